@@ -21,15 +21,41 @@
 #ifndef GTIRB_ALLOCATOR_H
 #define GTIRB_ALLOCATOR_H
 
+#include <gtirb/Export.hpp>
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <iterator>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+/// The size of the huge pages slabs are aligned to when huge pages are
+/// enabled.
+constexpr size_t HugePageSize = size_t(1) << 21;
+
+/// Map \p Size bytes, aligned to HugePageSize, and ask the operating system to
+/// back them with huge pages. \p Size must be a multiple of HugePageSize.
+/// Where memory cannot be mapped directly, this falls back to malloc.
+GTIRB_EXPORT_API void* allocateHugePageSlab(size_t Size);
+
+/// Release memory returned by allocateHugePageSlab().
+GTIRB_EXPORT_API void deallocateHugePageSlab(void* Slab, size_t Size);
+
+/// Whether SpecificBumpPtrAllocator<T> must call the destructor of each
+/// object it holds when it is reset or destroyed.
+///
+/// This is false for trivially destructible types. It may be specialized as
+/// false for other types whose destructors have no effect which matters once
+/// the allocator releases its memory, so the allocator can release it without
+/// walking the objects.
+template <typename T>
+struct needs_destruction
+    : std::integral_constant<bool, !std::is_trivially_destructible<T>::value> {
+};
+
 /// Returns the next power of two (in 64-bits) that is strictly greater than A.
 /// Returns zero on overflow.
 inline uint64_t NextPowerOf2(uint64_t A) {
@@ -91,36 +117,65 @@ public:
   BumpPtrAllocatorImpl(BumpPtrAllocatorImpl&& Old)
       : CurPtr(Old.CurPtr), End(Old.End), Slabs(std::move(Old.Slabs)),
         CustomSizedSlabs(std::move(Old.CustomSizedSlabs)),
-        BytesAllocated(Old.BytesAllocated), RedZoneSize(Old.RedZoneSize) {
+        RetainedSlabs(std::move(Old.RetainedSlabs)),
+        BytesAllocated(Old.BytesAllocated), RedZoneSize(Old.RedZoneSize),
+        HugePages(Old.HugePages) {
     Old.CurPtr = Old.End = nullptr;
     Old.BytesAllocated = 0;
     Old.Slabs.clear();
     Old.CustomSizedSlabs.clear();
+    Old.RetainedSlabs.clear();
   }
 
   ~BumpPtrAllocatorImpl() {
-    DeallocateSlabs(Slabs.begin(), Slabs.end());
+    DeallocateAllSlabs();
     DeallocateCustomSizedSlabs();
   }
 
   BumpPtrAllocatorImpl& operator=(BumpPtrAllocatorImpl&& RHS) {
-    DeallocateSlabs(Slabs.begin(), Slabs.end());
+    DeallocateAllSlabs();
     DeallocateCustomSizedSlabs();
 
     CurPtr = RHS.CurPtr;
     End = RHS.End;
     BytesAllocated = RHS.BytesAllocated;
     RedZoneSize = RHS.RedZoneSize;
+    HugePages = RHS.HugePages;
     Slabs = std::move(RHS.Slabs);
     CustomSizedSlabs = std::move(RHS.CustomSizedSlabs);
+    RetainedSlabs = std::move(RHS.RetainedSlabs);
 
     RHS.CurPtr = RHS.End = nullptr;
     RHS.BytesAllocated = 0;
     RHS.Slabs.clear();
     RHS.CustomSizedSlabs.clear();
+    RHS.RetainedSlabs.clear();
     return *this;
   }
 
+  /// Forget every allocation, keeping up to \p MaxSlabs slabs to be reused by
+  /// later allocations and deallocating the rest.
+  ///
+  /// The first slabs are kept, and are reused in their original order, so
+  /// each keeps the size it would have had if newly allocated.
+  void Reset(size_t MaxSlabs = SIZE_MAX) {
+    // Slabs not yet reused from an earlier reset follow the current ones.
+    std::vector<void*> AllSlabs(std::move(Slabs));
+    AllSlabs.insert(AllSlabs.end(), RetainedSlabs.rbegin(),
+                    RetainedSlabs.rend());
+    size_t NumKept = std::min(MaxSlabs, AllSlabs.size());
+    DeallocateSlabs(AllSlabs.begin() + NumKept, AllSlabs.end(), NumKept);
+    DeallocateCustomSizedSlabs();
+
+    // Retained slabs are taken from the back, so store them in reverse.
+    RetainedSlabs.assign(std::make_reverse_iterator(AllSlabs.begin() + NumKept),
+                         AllSlabs.rend());
+    Slabs.clear();
+    CustomSizedSlabs.clear();
+    CurPtr = End = nullptr;
+    BytesAllocated = 0;
+  }
+
   /// Allocate space at the specified alignment.
   void* Allocate(size_t Size, size_t Alignment) {
     assert(Alignment > 0 && "0-byte alignnment is not allowed. Use 1 instead.");
@@ -194,7 +249,7 @@ public:
   size_t GetNumSlabs() const { return Slabs.size() + CustomSizedSlabs.size(); }
 
   size_t getTotalMemory() const {
-    size_t TotalMemory = 0;
+    size_t TotalMemory = getRetainedMemory();
     for (auto I = Slabs.begin(), E = Slabs.end(); I != E; ++I)
       TotalMemory += computeSlabSize(std::distance(Slabs.begin(), I));
     for (auto& PtrAndSize : CustomSizedSlabs)
@@ -204,8 +259,36 @@ public:
 
   size_t getBytesAllocated() const { return BytesAllocated; }
 
+  /// Return the number of bytes left for allocation in the current slab and
+  /// in slabs kept for reuse by Reset().
+  size_t getBytesRemaining() const {
+    return size_t(End - CurPtr) + getRetainedMemory();
+  }
+
   void setRedZoneSize(size_t NewSize) { RedZoneSize = NewSize; }
 
+  /// Control whether slabs are backed by huge pages.
+  ///
+  /// When enabled, slabs grow quickly to HugePageSize, and slabs of at least
+  /// that size are mapped directly from the operating system, aligned, and
+  /// marked to be backed by huge pages. This reduces TLB misses when scanning
+  /// many objects. Since slab sizes, and how slabs are freed, depend on this
+  /// setting, it can only be changed while the allocator holds no slabs.
+  ///
+  /// \return Whether the setting was applied; false if slabs are held, in
+  /// which case nothing changes.
+  bool setHugePages(bool Enable) {
+    if (holdsSlabs())
+      return false;
+    HugePages = Enable;
+    return true;
+  }
+
+  bool getHugePages() const { return HugePages; }
+
+  /// Return whether any slabs are allocated or kept for reuse.
+  bool holdsSlabs() const { return !Slabs.empty() || !RetainedSlabs.empty(); }
+
 private:
   /// The current pointer into the current slab.
   ///
@@ -221,6 +304,10 @@ private:
   /// Custom-sized slabs allocated for too-large allocation requests.
   std::vector<std::pair<void*, size_t>> CustomSizedSlabs;
 
+  /// Slabs kept by Reset() to be reused, in reverse order. The last one will
+  /// become slab number Slabs.size().
+  std::vector<void*> RetainedSlabs;
+
   /// How many bytes we've allocated.
   ///
   /// Used so that we can compute how much space was wasted.
@@ -230,12 +317,24 @@ private:
   /// a sanitizer.
   size_t RedZoneSize = 1;
 
-  static size_t computeSlabSize(size_t SlabIdx) {
+  /// Whether large slabs are backed by huge pages.
+  bool HugePages = false;
+
+  size_t computeSlabSize(size_t SlabIdx) const {
     // Scale the actual allocated slab size based on the number of slabs
     // allocated. Every 128 slabs allocated, we double the allocated size to
     // reduce allocation frequency, but saturate at multiplying the slab size by
     // 2^30.
-    return SlabSize * ((size_t)1 << std::min<size_t>(30, SlabIdx / 128));
+    size_t Size = SlabSize * ((size_t)1 << std::min<size_t>(30, SlabIdx / 128));
+    // With huge pages, double every slab until a slab fills a huge page.
+    if (HugePages && Size < HugePageSize)
+      Size = std::min(HugePageSize,
+                      SlabSize * ((size_t)1 << std::min<size_t>(30, SlabIdx)));
+    return Size;
+  }
+
+  bool isHugePageSlab(size_t Size) const {
+    return HugePages && Size >= HugePageSize && Size % HugePageSize == 0;
   }
 
   /// Allocate a new slab and move the bump pointers over into the new
@@ -243,7 +342,15 @@ private:
   void StartNewSlab() {
     size_t AllocatedSlabSize = computeSlabSize(Slabs.size());
 
-    void* NewSlab = std::malloc(AllocatedSlabSize);
+    void* NewSlab;
+    if (!RetainedSlabs.empty()) {
+      NewSlab = RetainedSlabs.back();
+      RetainedSlabs.pop_back();
+    } else if (isHugePageSlab(AllocatedSlabSize)) {
+      NewSlab = allocateHugePageSlab(AllocatedSlabSize);
+    } else {
+      NewSlab = std::malloc(AllocatedSlabSize);
+    }
     // We own the new slab and don't want anyone reading anything other than
     // pieces returned from this method.  So poison the whole slab.
     //    __asan_poison_memory_region(NewSlab, AllocatedSlabSize);
@@ -253,14 +360,35 @@ private:
     End = ((char*)NewSlab) + AllocatedSlabSize;
   }
 
-  /// Deallocate a sequence of slabs.
+  /// Return the total size of the slabs kept for reuse.
+  size_t getRetainedMemory() const {
+    size_t TotalMemory = 0;
+    for (size_t I = 0; I < RetainedSlabs.size(); ++I)
+      TotalMemory += computeSlabSize(Slabs.size() + I);
+    return TotalMemory;
+  }
+
+  /// Deallocate a sequence of slabs, the first of which is slab number
+  /// \p SlabIdx.
   void DeallocateSlabs(std::vector<void*>::iterator I,
-                       std::vector<void*>::iterator E) {
-    for (; I != E; ++I) {
-      std::free(*I);
+                       std::vector<void*>::iterator E, size_t SlabIdx) {
+    for (; I != E; ++I, ++SlabIdx) {
+      size_t Size = computeSlabSize(SlabIdx);
+      if (isHugePageSlab(Size))
+        deallocateHugePageSlab(*I, Size);
+      else
+        std::free(*I);
     }
   }
 
+  /// Deallocate the current slabs and those kept for reuse.
+  void DeallocateAllSlabs() {
+    DeallocateSlabs(Slabs.begin(), Slabs.end(), 0);
+    // Retained slabs are stored in reverse.
+    std::vector<void*> Retained(RetainedSlabs.rbegin(), RetainedSlabs.rend());
+    DeallocateSlabs(Retained.begin(), Retained.end(), Slabs.size());
+  }
+
   /// Deallocate all memory for custom sized slabs.
   void DeallocateCustomSizedSlabs() {
     for (auto& PtrAndSize : CustomSizedSlabs) {
@@ -290,32 +418,87 @@ public:
     Allocator.setRedZoneSize(0);
   }
   SpecificBumpPtrAllocator(SpecificBumpPtrAllocator&& Old)
-      : Allocator(std::move(Old.Allocator)) {}
+      : Allocator(std::move(Old.Allocator)),
+        FreeList(std::move(Old.FreeList)) {
+    Old.FreeList.clear();
+  }
   ~SpecificBumpPtrAllocator() { DestroyAll(); }
 
   SpecificBumpPtrAllocator& operator=(SpecificBumpPtrAllocator&& RHS) {
     Allocator = std::move(RHS.Allocator);
+    FreeList = std::move(RHS.FreeList);
+    RHS.FreeList.clear();
     return *this;
   }
 
   /// Allocate space for an array of objects without constructing them.
-  T* Allocate(size_t num = 1) { return Allocator.Allocate<T>(num); }
+  ///
+  /// A single object reuses the most recently deallocated slot, if any.
+  T* Allocate(size_t num = 1) {
+    if (num == 1 && !FreeList.empty()) {
+      T* Ptr = FreeList.back();
+      FreeList.pop_back();
+      return Ptr;
+    }
+    return Allocator.Allocate<T>(num);
+  }
+
+  /// Make the slot of an object available to later calls to Allocate().
+  ///
+  /// The object must already have been destroyed, and must have been
+  /// allocated by this allocator.
+  void Deallocate(T* Ptr) { FreeList.push_back(Ptr); }
+
+  /// Return the number of objects allocated and not deallocated.
+  size_t getNumAllocated() const {
+    return Allocator.getBytesAllocated() / sizeof(T) - FreeList.size();
+  }
+
+  /// Return the number of deallocated slots waiting to be reused.
+  size_t getNumFree() const { return FreeList.size(); }
+
+  /// Call the destructor of each allocated object, then forget every
+  /// allocation while keeping up to \p MaxSlabs slabs for reuse.
+  void Reset(size_t MaxSlabs = SIZE_MAX) {
+    DestroyAll();
+    FreeList.clear();
+    Allocator.Reset(MaxSlabs);
+  }
+
+  /// Return the underlying allocator, e.g. to inspect its memory usage.
+  const BumpPtrAllocator& getAllocator() const { return Allocator; }
+
+  /// Control whether slabs are backed by huge pages.
+  ///
+  /// \see BumpPtrAllocatorImpl::setHugePages()
+  bool setHugePages(bool Enable) { return Allocator.setHugePages(Enable); }
 
 private:
-  /// Call the destructor of each allocated object and deallocate all but the
-  /// current slab and reset the current pointer to the beginning of it, freeing
-  /// all memory allocated so far.
+  /// Slots of deallocated objects, reused by Allocate() in LIFO order.
+  std::vector<T*> FreeList;
+
+  /// Call the destructor of each allocated object which has not been
+  /// deallocated.
   void DestroyAll() {
-    auto DestroyElements = [](char* Begin, char* End) {
+    // The memory can simply be released.
+    if constexpr (!needs_destruction<T>::value)
+      return;
+
+    // Deallocated slots hold no object, so look each slot up among them.
+    std::vector<T*> Freed(FreeList);
+    std::sort(Freed.begin(), Freed.end());
+    auto DestroyElements = [&Freed](char* Begin, char* End) {
       assert(Begin == (char*)alignAddr(Begin, alignof(T)));
       for (char* Ptr = Begin; Ptr + sizeof(T) <= End; Ptr += sizeof(T))
-        reinterpret_cast<T*>(Ptr)->~T();
+        if (Freed.empty() || !std::binary_search(Freed.begin(), Freed.end(),
+                                                 reinterpret_cast<T*>(Ptr)))
+          reinterpret_cast<T*>(Ptr)->~T();
     };
 
     for (auto I = Allocator.Slabs.begin(), E = Allocator.Slabs.end(); I != E;
          ++I) {
-      size_t AllocatedSlabSize = BumpPtrAllocator::computeSlabSize(
-          std::distance(Allocator.Slabs.begin(), I));
+      size_t AllocatedSlabSize =
+          Allocator.computeSlabSize(std::distance(Allocator.Slabs.begin(), I));
       char* Begin = (char*)alignAddr(*I, alignof(T));
       char* End = *I == Allocator.Slabs.back() ? Allocator.CurPtr
                                                : (char*)*I + AllocatedSlabSize;
@@ -28,6 +28,10 @@ namespace proto {
 class AuxDataContainer;
 }
 
+namespace google::protobuf::io {
+class CodedOutputStream;
+}
+
 namespace gtirb {
 
 /// \class AuxDataContainer
@@ -165,6 +169,21 @@ public:
   /// \return The deserialized IR object, or null on failure.
   static void fromProtobuf(AuxDataContainer* in, Context& C,
                            const MessageType& Message);
+
+  /// \brief Get the size of the serialized AuxDataContainer message.
+  ///
+  /// Each \ref AuxData is serialized in turn to measure it, so this is about
+  /// as expensive as writeProtobuf().
+  ///
+  /// \return The number of bytes writeProtobuf() will write.
+  size_t protobufSize() const;
+
+  /// \brief Serialize directly to a stream, one \ref AuxData at a time.
+  ///
+  /// \param Out  The stream to write to.
+  ///
+  /// \return void
+  void writeProtobuf(google::protobuf::io::CodedOutputStream& Out) const;
 protected:
   AuxDataContainer(Context& C, Kind knd) : Node(C, knd) {}
   /// @endcond
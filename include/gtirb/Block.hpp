@@ -106,6 +106,10 @@ private:
   uint64_t DecodeMode{0};
 
   friend class Context;
+
+  // Allow these methods to update Blocks.
+  friend void setAddress(Module& M, Block& B, Addr A);
+  friend void setSize(Module& M, Block& B, uint64_t S);
 };
 
 /// \class InstructionRef
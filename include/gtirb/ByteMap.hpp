@@ -32,6 +32,10 @@ namespace proto {
 class ByteMap;
 }
 
+namespace google::protobuf::io {
+class CodedOutputStream;
+}
+
 namespace gtirb {
 class Context;
 class ImageByteMap;
@@ -66,6 +70,7 @@ public:
       // Overwrite data in existing region
       if (containsAddr(Current, A) && Limit <= addressLimit(Current)) {
         auto Offset = A - Current.Address;
+        Current.makeWritable();
         std::copy(Data.begin(), Data.end(), Current.Data.begin() + Offset);
         return true;
       }
@@ -77,12 +82,13 @@ public:
           return false;
         }
 
+        Current.makeWritable();
         Current.Data.reserve(Current.Data.size() + data_size);
         std::copy(Data.begin(), Data.end(), std::back_inserter(Current.Data));
         // Merge with subsequent region
         if (HasNext && Limit == Regions[i + 1].Address) {
-          const auto& D = Regions[i + 1].Data;
-          Current.Data.reserve(Current.Data.size() + D.size());
+          const auto& D = Regions[i + 1];
+          Current.Data.reserve(Current.Data.size() + D.getSize());
           std::copy(D.begin(), D.end(), std::back_inserter(Current.Data));
           this->Regions.erase(this->Regions.begin() + i + 1);
         }
@@ -93,6 +99,7 @@ public:
       if (Limit == Current.Address) {
         // Note: this is probably O(N^2), moving existing data on each inserted
         // element.
+        Current.makeWritable();
         std::copy(Data.begin(), Data.end(),
                   std::inserter(Current.Data, Current.Data.begin()));
         Current.Address = A;
@@ -119,8 +126,7 @@ public:
   }
 
   /// \brief A constant range of bytes.
-  using const_range =
-      boost::iterator_range<std::vector<std::byte>::const_iterator>;
+  using const_range = boost::iterator_range<const std::byte*>;
 
   /// \brief Get the data at the specified address.
   ///
@@ -155,13 +161,66 @@ public:
   /// \return The deserialized ByteMap object, or null on failure.
   void fromProtobuf(Context& C, const MessageType& Message);
 
+  /// \brief Get the size of the serialized ByteMap message.
+  ///
+  /// \return The number of bytes writeProtobuf() will write.
+  size_t protobufSize() const;
+
+  /// \brief Serialize directly to a stream, without building a message.
+  ///
+  /// The output is identical to serializing the message produced by
+  /// toProtobuf(), but region contents are written from their existing
+  /// storage rather than copied.
+  ///
+  /// \param Out  The stream to write to.
+  ///
+  /// \return void
+  void writeProtobuf(google::protobuf::io::CodedOutputStream& Out) const;
+
+  /// \brief Add a region whose contents are held in externally owned memory.
+  ///
+  /// The bytes are not copied; they must remain valid for the lifetime of the
+  /// ByteMap. They are copied on the first modification of the region.
+  ///
+  /// \param A      The address of the first byte of the region.
+  /// \param Bytes  The contents of the region.
+  /// \param Size   The number of bytes in the region.
+  ///
+  /// \return \c true if the region was added, or \c false if it would overlap
+  /// an existing region.
+  bool addMappedRegion(Addr A, const std::byte* Bytes, size_t Size);
+
+  /// \brief A contiguous run of bytes in the map.
+  ///
+  /// The bytes are either owned by the region (\ref Data) or, for regions
+  /// loaded from a memory-mapped file, held by the \ref Context in read-only
+  /// memory (\ref Mapped). Mapped regions are copied into \ref Data before
+  /// they are modified.
   struct Region {
     Addr Address;
     std::vector<std::byte> Data;
+    const std::byte* Mapped{nullptr};
+    size_t MappedSize{0};
 
     Addr getAddress() const { return this->Address; }
 
-    uint64_t getSize() const { return this->Data.size(); }
+    uint64_t getSize() const {
+      return this->Mapped ? this->MappedSize : this->Data.size();
+    }
+
+    const std::byte* begin() const {
+      return this->Mapped ? this->Mapped : this->Data.data();
+    }
+
+    const std::byte* end() const { return this->begin() + this->getSize(); }
+
+    void makeWritable() {
+      if (this->Mapped) {
+        this->Data.assign(this->Mapped, this->Mapped + this->MappedSize);
+        this->Mapped = nullptr;
+        this->MappedSize = 0;
+      }
+    }
   };
   /// @endcond
 
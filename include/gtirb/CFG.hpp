@@ -39,6 +39,7 @@ class CFG;
 
 namespace gtirb {
 class CfgNode;
+class UUIDTable;
 
 /// \defgroup CFG_GROUP Control Flow Graphs (CFGs)
 /// \brief Interprocedural control flow graph, with vertices of type
@@ -224,6 +225,19 @@ GTIRB_EXPORT_API CFG::vertex_descriptor addVertex(CfgNode* B, CFG& Cfg);
 GTIRB_EXPORT_API std::optional<CFG::vertex_descriptor>
 getVertex(const CfgNode* N, const CFG& Cfg);
 
+/// \ingroup CFG_GROUP
+/// \brief Remove a node, and every edge to or from it, from the graph.
+///
+/// The most recently added node takes the vertex descriptor of \p N, so
+/// only its descriptor and those of edges to or from either node are
+/// invalidated. This takes time proportional to the number of those edges.
+///
+/// \param N    The node to remove.
+/// \param Cfg  The graph to modify.
+///
+/// \return \c true if the node was in the graph, \c false otherwise.
+GTIRB_EXPORT_API bool removeVertex(const CfgNode* N, CFG& Cfg);
+
 /// \ingroup CFG_GROUP
 /// \brief Create a new edge between two CFG nodes if they exist in the graph.
 ///
@@ -289,16 +303,28 @@ blocks(const CFG& Cfg);
 /// component blocks (\ref Block).
 GTIRB_EXPORT_API proto::CFG toProtobuf(const CFG& Cfg);
 
+/// \ingroup CFG_GROUP
+/// \brief Serialize a \ref CFG into an existing protobuf message.
+///
+/// \param Cfg          The CFG to serialize.
+/// \param[out] Message  Serialize into this message.
+///
+/// \return void
+GTIRB_EXPORT_API void toProtobuf(const CFG& Cfg, proto::CFG* Message);
+
 /// \ingroup CFG_GROUP
 /// \brief Initialize a \ref CFG from a protobuf message.
 ///
 /// \param      C        The Context in which the deserialized CFG will be held.
 /// \param      Message  The protobuf message from which to deserialize.
 /// \param[out] Result   The CFG to initialize.
+/// \param      References  If not null, the table which node references saved
+///                         as ids index into.
 ///
 /// \return void
 GTIRB_EXPORT_API void fromProtobuf(Context& C, CFG& Result,
-                                   const proto::CFG& Message);
+                                   const proto::CFG& Message,
+                                   const UUIDTable* References = nullptr);
 /// @endcond
 } // namespace gtirb
 
@@ -17,9 +17,20 @@
 
 #include <gtirb/Allocator.hpp>
 #include <gtirb/Export.hpp>
+#include <gtirb/NodeRegistry.hpp>
 #include <boost/uuid/uuid.hpp>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <cstdlib>
-#include <map>
+#include <initializer_list>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 /// \file Context.hpp
 /// \brief Class \ref gtirb::Context and related operators.
@@ -39,10 +50,106 @@ class Block;
 class DataObject;
 class ImageByteMap;
 class IR;
+class MappedFile;
 class Module;
 class ProxyBlock;
 class Section;
 class Symbol;
+} // namespace gtirb
+
+/// \cond INTERNAL
+// Apart from members which need none, these nodes' destructors only
+// unregister them, and the Context discards its registry wholesale when it is
+// reset or destroyed. Their allocators can release them without walking them.
+template <> struct needs_destruction<gtirb::Node> : std::false_type {};
+template <> struct needs_destruction<gtirb::Block> : std::false_type {};
+template <> struct needs_destruction<gtirb::DataObject> : std::false_type {};
+template <> struct needs_destruction<gtirb::ProxyBlock> : std::false_type {};
+/// \endcond
+
+namespace gtirb {
+
+/// \brief Memory used by the nodes of one type in a \ref Context.
+///
+/// \see Context::getMemoryStats()
+struct NodeMemoryStats {
+  /// \brief The number of nodes currently allocated.
+  size_t LiveCount{0};
+
+  /// \brief The total size of the slabs holding the nodes.
+  size_t SlabBytes{0};
+
+  /// \brief The bytes of the slabs occupied by nodes.
+  size_t UsedBytes{0};
+
+  /// \brief The bytes still available for new nodes in current slabs,
+  /// including the slots of destroyed nodes.
+  size_t FreeBytes{0};
+
+  /// \brief The bytes at the ends of slabs which were too small for another
+  /// node, and so will never be used.
+  size_t WastedBytes{0};
+
+  /// \brief Add the statistics of another set of nodes to these.
+  ///
+  /// \return This object.
+  NodeMemoryStats& operator+=(const NodeMemoryStats& Other) {
+    LiveCount += Other.LiveCount;
+    SlabBytes += Other.SlabBytes;
+    UsedBytes += Other.UsedBytes;
+    FreeBytes += Other.FreeBytes;
+    WastedBytes += Other.WastedBytes;
+    return *this;
+  }
+};
+
+/// \brief Memory used by a \ref Context, broken down by node type.
+///
+/// \see Context::getMemoryStats()
+struct ContextMemoryStats {
+  NodeMemoryStats Nodes;         ///< Plain \ref Node objects.
+  NodeMemoryStats Blocks;        ///< \ref Block objects.
+  NodeMemoryStats DataObjects;   ///< \ref DataObject objects.
+  NodeMemoryStats ImageByteMaps; ///< \ref ImageByteMap objects.
+  NodeMemoryStats IRs;           ///< \ref IR objects.
+  NodeMemoryStats Modules;       ///< \ref Module objects.
+  NodeMemoryStats ProxyBlocks;   ///< \ref ProxyBlock objects.
+  NodeMemoryStats Sections;      ///< \ref Section objects.
+  NodeMemoryStats Symbols;       ///< \ref Symbol objects.
+
+  /// \brief The number of nodes registered under their UUIDs.
+  size_t RegisteredNodes{0};
+
+  /// \brief The bytes used by the tables mapping UUIDs to nodes.
+  size_t RegistryBytes{0};
+
+  /// \brief The number of distinct strings interned.
+  ///
+  /// \see Context::internString()
+  size_t InternedStrings{0};
+
+  /// \brief An estimate of the bytes used by the interned strings and the
+  /// tables holding them.
+  ///
+  /// \see Context::internString()
+  size_t InternedStringBytes{0};
+
+  /// \brief The bytes obtained from the heap for the indexes inside nodes.
+  ///
+  /// \see Context::getMemoryResource()
+  size_t IndexBytes{0};
+
+  /// \brief Get the statistics for nodes of all types combined.
+  ///
+  /// \return The combined statistics.
+  NodeMemoryStats total() const {
+    NodeMemoryStats Total;
+    for (const auto* S : {&Nodes, &Blocks, &DataObjects, &ImageByteMaps, &IRs,
+                          &Modules, &ProxyBlocks, &Sections, &Symbols})
+      Total += *S;
+    return Total;
+  }
+};
 
 /// \class Context
 ///
@@ -55,34 +162,159 @@ class Symbol;
 ///
 /// Any API that requires a \ref Context object may potentially
 /// allocate memory within that context. Destroying the Context object
-/// will release that memory.  In a multithreaded environment, sharing
-/// a Context object across multiple threads can introduce data races,
-/// so protecting the object with a locking primitive is recommended.
+/// will release that memory. Nodes may be created in the same Context from
+/// several threads at once, but the nodes themselves are not protected:
+/// sharing a Node across threads can introduce data races, so protecting it
+/// with a locking primitive is recommended.
 class GTIRB_EXPORT_API Context {
-  // Note: this must be declared first so it outlives the allocators. They
-  // will access the UuidMap during their destructors to unregister nodes.
-  std::map<UUID, Node*> UuidMap;
-
-  // Allocate each node type in a separate arena.
-  mutable SpecificBumpPtrAllocator<Node> NodeAllocator;
-  mutable SpecificBumpPtrAllocator<Block> BlockAllocator;
-  mutable SpecificBumpPtrAllocator<DataObject> DataObjectAllocator;
-  mutable SpecificBumpPtrAllocator<ImageByteMap> ImageByteMapAllocator;
-  mutable SpecificBumpPtrAllocator<IR> IrAllocator;
-  mutable SpecificBumpPtrAllocator<Module> ModuleAllocator;
-  mutable SpecificBumpPtrAllocator<ProxyBlock> ProxyBlockAllocator;
-  mutable SpecificBumpPtrAllocator<Section> SectionAllocator;
-  mutable SpecificBumpPtrAllocator<Symbol> SymbolAllocator;
+  // Nodes may be created, registered and looked up from several threads at
+  // once. To keep threads from contending, the registry and the allocators
+  // are split into shards, each with its own lock.
+  static constexpr unsigned ShardBits = 4;
+  static constexpr size_t NumShards = size_t(1) << ShardBits;
+
+  // Note: the registry must be declared before the allocators so it outlives
+  // them. Nodes access it during their destructors to unregister themselves.
+  //
+  // Each UUID belongs to the registry shard picked by the top bits of its
+  // hash. The table within the shard is indexed by the low bits.
+  struct RegistryShard {
+    mutable std::mutex Mutex;
+    NodeRegistry Nodes;
+  };
+  std::array<RegistryShard, NumShards> Registry;
+
+  // Interned strings, in the shard picked by the top bits of their hash,
+  // each with the number of times it is held. Each string lives in its own
+  // node of the map, so its address never changes. Nodes refer to these, so
+  // they are declared before the allocators.
+  struct StringShard {
+    mutable std::mutex Mutex;
+    std::unordered_map<std::string, size_t> Strings;
+  };
+  std::array<StringShard, NumShards> InternedStrings;
+
+  // In sequential mode, UUIDs are formed from SequencePrefix and an
+  // incrementing counter rather than drawn from a random generator.
+  std::atomic<bool> SequentialUUIDs{false};
+  std::atomic<uint64_t> SequencePrefix{0};
+  std::atomic<uint64_t> SequenceCounter{0};
+
+  // If set, new nodes get no UUID until one is requested.
+  std::atomic<bool> LazyUUIDs{false};
+  // Serialize the first getUUID() calls on lazy nodes, by allocator shard.
+  std::array<std::mutex, NumShards> LazyUUIDMutexes;
+
+  // Set while every node is being destroyed, so nodes need not unregister
+  // themselves one at a time. Read by node destructors on any thread.
+  std::atomic<bool> TearingDown{false};
+
+  // Files mapped into memory while loading, guarded by Mutex. Nodes may refer
+  // directly to the mapped bytes, so these are declared before the allocators
+  // to outlive them.
+  mutable std::mutex Mutex;
+  std::vector<std::unique_ptr<MappedFile>> MappedFiles;
+
+  // Passes allocations to the heap, counting the bytes outstanding.
+  class CountingResource : public std::pmr::memory_resource {
+  public:
+    size_t getBytesAllocated() const { return BytesAllocated; }
+
+  private:
+    void* do_allocate(size_t Bytes, size_t Alignment) override {
+      void* P = std::pmr::new_delete_resource()->allocate(Bytes, Alignment);
+      BytesAllocated += Bytes;
+      return P;
+    }
+    void do_deallocate(void* P, size_t Bytes, size_t Alignment) override {
+      std::pmr::new_delete_resource()->deallocate(P, Bytes, Alignment);
+      BytesAllocated -= Bytes;
+    }
+    bool do_is_equal(const memory_resource& Other) const noexcept override {
+      return this == &Other;
+    }
+
+    std::atomic<size_t> BytesAllocated{0};
+  };
+
+  // Memory for the indexes inside nodes, such as a Module's containers. It is
+  // declared before the allocators so the nodes can release index memory as
+  // they are destroyed; whatever the pools still hold is then freed in bulk.
+  CountingResource IndexHeap;
+  std::pmr::synchronized_pool_resource IndexMemory{&IndexHeap};
+
+  // Each thread allocates nodes, and draws random UUIDs, from one shard, so
+  // threads creating nodes at the same time rarely share a lock or a slab.
+  // Within a shard, each node type is allocated in a separate arena.
+  struct AllocatorShard {
+    std::mutex Mutex;
+    std::mt19937_64 UuidRng;
+    SpecificBumpPtrAllocator<Node> NodeAllocator;
+    SpecificBumpPtrAllocator<Block> BlockAllocator;
+    SpecificBumpPtrAllocator<DataObject> DataObjectAllocator;
+    SpecificBumpPtrAllocator<ImageByteMap> ImageByteMapAllocator;
+    SpecificBumpPtrAllocator<IR> IrAllocator;
+    SpecificBumpPtrAllocator<Module> ModuleAllocator;
+    SpecificBumpPtrAllocator<ProxyBlock> ProxyBlockAllocator;
+    SpecificBumpPtrAllocator<Section> SectionAllocator;
+    SpecificBumpPtrAllocator<Symbol> SymbolAllocator;
+  };
+  mutable std::array<AllocatorShard, NumShards> Allocators;
+
+  // Get the allocator shard used by the calling thread, or its index.
+  size_t threadShardIndex() const;
+  AllocatorShard& threadShard() const { return Allocators[threadShardIndex()]; }
+
+  RegistryShard& registryShard(const UUID& ID) {
+    return Registry[NodeRegistry::hash(ID) >> (64 - ShardBits)];
+  }
+  const RegistryShard& registryShard(const UUID& ID) const {
+    return Registry[NodeRegistry::hash(ID) >> (64 - ShardBits)];
+  }
+
+  // Seed the UUID generator of every allocator shard.
+  void seedUUIDs(std::vector<uint32_t> Seed);
 
   /// \copybrief gtirb::Node
   friend class Node;
+  friend class IR;
+  friend class Module; // Allow Module to destroy the nodes it erases.
 
-  void registerNode(const UUID& ID, Node* N) { UuidMap[ID] = N; }
+  void registerNode(const UUID& ID, Node* N) {
+    RegistryShard& Shard = registryShard(ID);
+    std::lock_guard<std::mutex> Lock(Shard.Mutex);
+    Shard.Nodes.insert(ID, N);
+  }
+
+  // Register a node with a newly generated UUID, unless another node already
+  // has that UUID.
+  bool registerNewUUID(const UUID& ID, Node* N) {
+    RegistryShard& Shard = registryShard(ID);
+    std::lock_guard<std::mutex> Lock(Shard.Mutex);
+    return Shard.Nodes.insertNew(ID, N);
+  }
+
+  // Generate a UUID for a new node and register the node with it. Returns
+  // the nil UUID, and does not register the node, if UUIDs are lazy.
+  UUID registerNewNode(Node* N) {
+    return LazyUUIDs.load(std::memory_order_relaxed) ? UUID() : assignUUID(N);
+  }
+
+  // Generate a UUID for a node and register the node with it.
+  UUID assignUUID(Node* N);
+  // Give a lazy node its UUID, unless another thread already has.
+  void assignLazyUUID(const Node* N);
 
   void unregisterNode(const Node* N);
   const Node* findNode(const UUID& ID) const;
   Node* findNode(const UUID& ID);
 
+  /// \brief Take ownership of a mapped file, keeping it alive for as long as
+  /// the Context.
+  ///
+  /// \return void
+  void addMappedFile(std::unique_ptr<MappedFile> F);
+
   /// \brief Allocates a chunk of memory for an object of type \ref T.
   ///
   /// \tparam T   The type of object for which to allocate memory.
@@ -93,21 +325,168 @@ class GTIRB_EXPORT_API Context {
 
   /// \brief Deallocates memory allocated through a call to Allocate().
   ///
+  /// The memory goes onto a free list of the allocator shard it came from,
+  /// and is reused by the next object of type \ref T allocated from that
+  /// shard. It is not returned to the system until the Context is reset or
+  /// destroyed.
+  ///
+  /// \tparam T      The type of object the memory was allocated for.
+  /// \param P       The memory, which must not hold a live object.
+  /// \param Shard   The index of the allocator shard it came from.
+  ///
   /// \return void
+  template <class T> void Deallocate(void* P, size_t Shard) const;
+
+  /// \brief Destroy an object created with Create(), and deallocate its
+  /// memory.
   ///
-  /// Deallocation of individual pointers leads to memory fragmentation, which
-  /// is why this function is currently a placeholder that does not actually
-  /// perform the deallocation. Instead, memory is freed as a whole when the
-  /// \ref Context object is destroyed.
-  void Deallocate(void*, size_t) const {
-    // Noop -- we don't want callers to deallocate individual allocations, but
-    // should instead deallocate the entire Context object to free memory.
+  /// \tparam NodeTy  The dynamic type of the object.
+  /// \param N        The object to destroy.
+  ///
+  /// \return void
+  template <typename NodeTy> static void Destroy(NodeTy* N) {
+    Context* C = N->Ctx;
+    size_t Shard = N->AllocatorShard;
+    N->~NodeTy();
+    C->Deallocate<NodeTy>(N, Shard);
   }
 
 public:
   Context();
   ~Context();
 
+  /// \brief Give new nodes random UUIDs. This is the default.
+  ///
+  /// UUIDs come from a generator owned by the Context, which is seeded once
+  /// from the operating system's entropy source.
+  ///
+  /// \return void
+  void useRandomUUIDs();
+
+  /// \brief Give new nodes random UUIDs from a generator with a fixed seed.
+  ///
+  /// A program which creates the same nodes in the same order gets the same
+  /// UUIDs on every run. Nodes which already exist keep their UUIDs; should
+  /// the generator produce one of them again, for instance after reseeding
+  /// with an earlier seed, that UUID is skipped.
+  ///
+  /// \param Seed  The seed for the generator.
+  ///
+  /// \return void
+  void useRandomUUIDs(uint64_t Seed);
+
+  /// \brief Give new nodes sequential UUIDs, for reproducible output.
+  ///
+  /// Each UUID holds Prefix in its first eight bytes and a counter, starting
+  /// at one, in its last eight bytes. IRs built with the same prefix will
+  /// have UUIDs in common, so they cannot be loaded into one Context.
+  ///
+  /// The counter restarts only when the Context is reset, so calling this
+  /// again with the same prefix never reissues a UUID held by a live node.
+  /// UUIDs held by nodes loaded from elsewhere are skipped.
+  ///
+  /// \param Prefix  The first eight bytes of every UUID.
+  ///
+  /// \return void
+  void useSequentialUUIDs(uint64_t Prefix = 0);
+
+  /// \brief Destroy every node in this Context, keeping the allocated memory
+  /// for the nodes created next.
+  ///
+  /// This is cheaper than destroying the Context and creating a new one when
+  /// processing many IRs in turn, and avoids fragmenting the heap. Mapped
+  /// files are released, and the UUID generation mode is kept, although the
+  /// sequential counter restarts. No other thread may use the Context or its
+  /// nodes during the reset, and pointers to its nodes become invalid.
+  ///
+  /// \param MaxSlabs  The maximum number of slabs to keep for each node type
+  ///                  in each of the Context's allocator shards. Any others
+  ///                  are released. If zero, the memory pooled for indexes
+  ///                  is released too. Interned strings are always
+  ///                  released.
+  ///
+  /// \return void
+  void reset(size_t MaxSlabs = SIZE_MAX);
+
+  /// \brief Control whether node memory is backed by huge pages.
+  ///
+  /// When enabled, the slabs nodes are allocated from grow quickly to the
+  /// size of a huge page (2 MiB), and are then mapped directly from the
+  /// operating system and marked to be backed by huge pages where that is
+  /// supported. This reduces TLB misses when working with millions of nodes,
+  /// at the cost of reserving more memory up front.
+  ///
+  /// This only takes effect before any nodes are created, or just after
+  /// reset(0), since slabs already allocated cannot change. Otherwise,
+  /// including after a reset() which keeps slabs, nothing changes.
+  ///
+  /// \param Enable  Whether to use huge pages.
+  ///
+  /// \return Whether the setting was applied.
+  bool setHugePages(bool Enable);
+
+  /// \brief Get the single copy of a string kept by this Context.
+  ///
+  /// Every string equal to \p S is interned as the same object, so interned
+  /// strings can be compared and hashed by address. Symbol names are
+  /// interned, so that symbols with the same name share its storage. May be
+  /// called from several threads at once.
+  ///
+  /// Each call holds the string once more. It is freed when every hold has
+  /// been given up with releaseString(), or when the Context is reset or
+  /// destroyed.
+  ///
+  /// \param S  The string to intern.
+  ///
+  /// \return The interned string.
+  const std::string& internString(const std::string& S);
+
+  /// \brief Give up one hold on an interned string, freeing it if that was
+  /// the last.
+  ///
+  /// \param S  A string returned by internString().
+  ///
+  /// \return void
+  void releaseString(const std::string& S);
+
+  /// \brief Find the interned copy of a string, without interning it.
+  ///
+  /// \param S  The string to look up.
+  ///
+  /// \return The interned string, or null if no equal string is interned.
+  const std::string* findInternedString(const std::string& S) const;
+
+  /// \brief Get the memory resource for the indexes inside nodes.
+  ///
+  /// A Module's containers allocate from this resource, which pools memory
+  /// for the lifetime of the Context. It may be used from several threads.
+  ///
+  /// \return The memory resource.
+  std::pmr::memory_resource* getMemoryResource() { return &IndexMemory; }
+
+  /// \brief Report the memory used by nodes in this Context.
+  ///
+  /// Memory owned by the nodes themselves is not included, apart from the
+  /// memory drawn from getMemoryResource() for their indexes.
+  ///
+  /// \return The memory statistics, broken down by node type.
+  ContextMemoryStats getMemoryStats() const;
+
+  /// \brief Control whether new nodes get their UUIDs lazily.
+  ///
+  /// When enabled, a new node is given a UUID and registered for lookup with
+  /// Node::getByUUID() only when Node::getUUID() is first called on it,
+  /// which includes serializing it. Nodes which are never looked up or saved
+  /// skip that work entirely. Nodes created before the mode changes are not
+  /// affected.
+  ///
+  /// \param Lazy  Whether UUIDs should be assigned lazily.
+  ///
+  /// \return void
+  void setLazyUUIDs(bool Lazy) {
+    LazyUUIDs.store(Lazy, std::memory_order_relaxed);
+  }
+
   /// \brief Create an object of type \ref T.
   ///
   /// \tparam NodeTy   The type of object for which to allocate memory.
@@ -117,7 +496,10 @@ public:
   /// \return A newly created object, allocated within the Context.
   template <typename NodeTy, typename... Args>
   NodeTy* Create(Args&&... TheArgs) {
-    return new (Allocate<NodeTy>()) NodeTy(std::forward<Args>(TheArgs)...);
+    NodeTy* N = new (Allocate<NodeTy>()) NodeTy(std::forward<Args>(TheArgs)...);
+    // Remember where the node came from, so Destroy() can give it back.
+    N->AllocatorShard = static_cast<uint8_t>(threadShardIndex());
+    return N;
   }
 };
 
@@ -131,6 +513,28 @@ template <> GTIRB_EXPORT_API void* Context::Allocate<ProxyBlock>() const;
 template <> GTIRB_EXPORT_API void* Context::Allocate<Section>() const;
 template <> GTIRB_EXPORT_API void* Context::Allocate<Symbol>() const;
 
+template <>
+GTIRB_EXPORT_API void Context::Deallocate<Node>(void* P, size_t Shard) const;
+template <>
+GTIRB_EXPORT_API void Context::Deallocate<Block>(void* P, size_t Shard) const;
+template <>
+GTIRB_EXPORT_API void Context::Deallocate<DataObject>(void* P,
+                                                      size_t Shard) const;
+template <>
+GTIRB_EXPORT_API void Context::Deallocate<ImageByteMap>(void* P,
+                                                        size_t Shard) const;
+template <>
+GTIRB_EXPORT_API void Context::Deallocate<IR>(void* P, size_t Shard) const;
+template <>
+GTIRB_EXPORT_API void Context::Deallocate<Module>(void* P, size_t Shard) const;
+template <>
+GTIRB_EXPORT_API void Context::Deallocate<ProxyBlock>(void* P,
+                                                      size_t Shard) const;
+template <>
+GTIRB_EXPORT_API void Context::Deallocate<Section>(void* P, size_t Shard) const;
+template <>
+GTIRB_EXPORT_API void Context::Deallocate<Symbol>(void* P, size_t Shard) const;
+
 } // namespace gtirb
 
 #endif // GTIRB_CONTEXT_H
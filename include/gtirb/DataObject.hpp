@@ -106,6 +106,10 @@ private:
   uint64_t Size{0};
 
   friend class Context;
+
+  // Allow these methods to update DataObjects.
+  friend void setAddress(Module& M, DataObject& D, Addr A);
+  friend void setSize(Module& M, DataObject& D, uint64_t S);
 };
 } // namespace gtirb
 
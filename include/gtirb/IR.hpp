@@ -23,7 +23,9 @@
 #include <boost/iterator/indirect_iterator.hpp>
 #include <boost/multi_index_container.hpp>
 #include <boost/range/iterator_range.hpp>
+#include <atomic>
 #include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -36,6 +38,15 @@ class IR;
 namespace gtirb {
 class Module;
 
+/// \enum NodeReferences
+///
+/// \brief How IR::save() writes references from one node to another.
+enum class NodeReferences : uint8_t {
+  ByUUID,  ///< Each reference holds the 16-byte UUID of the node.
+  ByIndex, ///< Each reference holds a varint index into one table of UUIDs
+           ///< for the IR, which makes files smaller and faster to load.
+};
+
 /// \class IR
 ///
 /// \brief A complete internal representation consisting of Modules
@@ -156,14 +167,26 @@ public:
       boost::indirect_iterator<ModuleSet::const_iterator, const Module>;
 
   /// \brief Returns an iterator to the first Module.
-  iterator begin() { return Modules.begin(); }
+  iterator begin() {
+    loadPendingModules();
+    return Modules.begin();
+  }
   /// \brief Returns an iterator to the element following the last Module.
-  iterator end() { return Modules.end(); }
+  iterator end() {
+    loadPendingModules();
+    return Modules.end();
+  }
   /// \brief Returns a constant iterator to the first Module.
-  const_iterator begin() const { return Modules.begin(); }
+  const_iterator begin() const {
+    loadPendingModules();
+    return Modules.begin();
+  }
   /// \brief Returns a constant iterator to the element following the last
   /// Module.
-  const_iterator end() const { return Modules.end(); }
+  const_iterator end() const {
+    loadPendingModules();
+    return Modules.end();
+  }
 
   /// \brief Range of \ref Module "Modules".
   ///
@@ -183,12 +206,42 @@ public:
     return boost::make_iterator_range(begin(), end());
   }
 
+  /// \brief Find the \ref Module "Modules" with a given name.
+  ///
+  /// If the IR was loaded with loadLazy(), only modules with this name are
+  /// deserialized.
+  ///
+  /// \param X The name to look up.
+  ///
+  /// \return The modules named \p X.
+  range findModules(const std::string& X) {
+    auto [First, Last] = findPendingModules(X);
+    return boost::make_iterator_range(iterator(First), iterator(Last));
+  }
+
+  /// \brief Find the \ref Module "Modules" with a given name.
+  ///
+  /// If the IR was loaded with loadLazy(), only modules with this name are
+  /// deserialized.
+  ///
+  /// \param X The name to look up.
+  ///
+  /// \return The modules named \p X.
+  const_range findModules(const std::string& X) const {
+    auto [First, Last] = findPendingModules(X);
+    return boost::make_iterator_range(const_iterator(First),
+                                      const_iterator(Last));
+  }
+
   /// \brief Adds a single module to the IR.
   ///
   /// \param M The Module object to add.
   ///
   /// \return void
-  void addModule(Module* M) { Modules.insert(M); }
+  void addModule(Module* M) {
+    loadPendingModules();
+    Modules.insert(M);
+  }
 
   /// \brief Adds one or more modules to the IR.
   ///
@@ -196,15 +249,33 @@ public:
   ///
   /// \return void
   void addModule(std::initializer_list<Module*> Ms) {
+    loadPendingModules();
     Modules.insert(std::begin(Ms), std::end(Ms));
   }
 
   /// \brief Serialize to an output stream in binary format.
   ///
+  /// Files written with NodeReferences::ByIndex can only be read by versions
+  /// of GTIRB which support that encoding.
+  ///
+  /// \param Out   The output stream.
+  /// \param Refs  How references between nodes are written.
+  ///
+  /// \return void
+  void save(std::ostream& Out,
+            NodeReferences Refs = NodeReferences::ByUUID) const;
+
+  /// \brief Serialize to an output stream in the indexed binary format.
+  ///
+  /// The indexed format starts with a table of contents giving the name,
+  /// UUID, ISA, and location of each module, followed by the modules
+  /// themselves. This lets loadLazy() deserialize only the modules which are
+  /// used. It can be read by load() and loadMapped() as well.
+  ///
   /// \param Out The output stream.
   ///
   /// \return void
-  void save(std::ostream& Out) const;
+  void saveIndexed(std::ostream& Out) const;
 
   /// \brief Serialize to an output stream in JSON format.
   ///
@@ -215,11 +286,66 @@ public:
 
   /// \brief Deserialize binary format from an input stream.
   ///
-  /// \param C   The Context in which this IR will be loaded.
-  /// \param In  The input stream.
+  /// \param C           The Context in which this IR will be loaded.
+  /// \param In          The input stream.
+  /// \param NumThreads  The number of threads to use to deserialize modules.
   ///
   /// \return The deserialized IR object.
-  static IR* load(Context& C, std::istream& In);
+  static IR* load(Context& C, std::istream& In, unsigned NumThreads = 1);
+
+  /// \brief Deserialize binary format from a file, without copying image
+  /// bytes.
+  ///
+  /// The file is mapped into memory and the regions of each \ref ImageByteMap
+  /// refer directly to the mapped bytes. The mapping is held by the Context
+  /// until it is destroyed. A region's bytes are copied the first time the
+  /// region is modified.
+  ///
+  /// \param C           The Context in which this IR will be loaded.
+  /// \param Path        The path of the file to load.
+  /// \param NumThreads  The number of threads to use to deserialize modules.
+  ///
+  /// \return The deserialized IR object, or null if the file could not be
+  /// mapped or parsed.
+  static IR* loadMapped(Context& C, const std::string& Path,
+                        unsigned NumThreads = 1);
+
+  /// \brief Deserialize the indexed binary format from a file, loading
+  /// modules on demand.
+  ///
+  /// The file is mapped into memory as for loadMapped(), but only its table
+  /// of contents and the IR's AuxData are deserialized immediately. Each
+  /// Module is deserialized the first time it is reached, either through a
+  /// name lookup with findModules() or by iterating over modules(). Until
+  /// then, its nodes cannot be found with Node::getByUUID(), and symbols in
+  /// other modules which refer to them have no referent.
+  ///
+  /// Until every module is loaded, modules are deserialized and looked up
+  /// under a lock, so threads may call the const member functions of a lazily
+  /// loaded IR concurrently. The modules in a range returned by findModules()
+  /// are safe to use, but iterating over the range itself while another
+  /// thread loads other modules is not; call loadModules() first if threads
+  /// share such ranges.
+  ///
+  /// A module whose payload turns out to be malformed when it is loaded is
+  /// left out of the IR. loadModules() reports whether this happened.
+  ///
+  /// Files which are not in the indexed format are loaded eagerly, as by
+  /// loadMapped().
+  ///
+  /// \param C     The Context in which this IR will be loaded.
+  /// \param Path  The path of the file to load.
+  ///
+  /// \return The deserialized IR object, or null if the file could not be
+  /// mapped or parsed.
+  static IR* loadLazy(Context& C, const std::string& Path);
+
+  /// \brief Deserialize every module of an IR loaded with loadLazy() which
+  /// has not been loaded yet.
+  ///
+  /// \return false if any module of the IR could not be loaded because its
+  /// payload was malformed, true otherwise.
+  bool loadModules() const;
 
   /// \brief Deserialize JSON format from an input stream.
   ///
@@ -241,18 +367,79 @@ public:
 
   /// \brief Construct a IR from a protobuf message.
   ///
-  /// \param C   The Context in which the deserialized IR will be held.
-  /// \param Message  The protobuf message from which to deserialize.
+  /// Modules are deserialized concurrently when \p NumThreads is greater than
+  /// one. References between modules are resolved either way.
+  ///
+  /// \param C           The Context in which the deserialized IR will be held.
+  /// \param Message     The protobuf message from which to deserialize.
+  /// \param NumThreads  The number of threads to use to deserialize modules.
   ///
   /// \return The deserialized IR object, or null on failure.
-  static IR* fromProtobuf(Context& C, const MessageType& Message);
+  static IR* fromProtobuf(Context& C, const MessageType& Message,
+                          unsigned NumThreads = 1);
 
   /// \cond INTERNAL
   static bool classof(const Node* N) { return N->getKind() == Kind::IR; }
   /// \endcond
 
 private:
-  ModuleSet Modules;
+  // A module found by loadLazy() which has not been deserialized yet.
+  struct PendingModule {
+    Context* C;
+    const std::byte* Begin;
+    const std::byte* End;
+  };
+
+  // A symbol from a lazily loaded module whose referent is in a module which
+  // has not been loaded yet.
+  struct UnresolvedReferent {
+    Module* M;
+    Symbol* S;
+    UUID Referent;
+  };
+
+  // A mutex which stays behind when the IR is moved.
+  struct LoadMutex : std::mutex {
+    LoadMutex() = default;
+    LoadMutex(LoadMutex&&) : std::mutex() {}
+    LoadMutex& operator=(LoadMutex&&) { return *this; }
+  };
+
+  // Deserialize every pending module.
+  void loadPendingModules() const;
+  // Deserialize the pending modules with a given name and find every module
+  // with that name.
+  std::pair<ModuleSet::iterator, ModuleSet::iterator>
+  findPendingModules(const std::string& Name) const;
+  // Requires PendingMutex to be held. Sets LoadFailed if a module's payload
+  // is malformed.
+  void loadPendingModules(
+      std::multimap<std::string, PendingModule>::iterator First,
+      std::multimap<std::string, PendingModule>::iterator Last) const;
+  // Set the referents which can now be found. Requires PendingMutex to be
+  // held.
+  void resolveReferents() const;
+
+  // A flag which keeps its value when the IR is moved.
+  struct PendingFlag : std::atomic<bool> {
+    PendingFlag() : std::atomic<bool>(false) {}
+    PendingFlag(PendingFlag&& F) : std::atomic<bool>(F.load()) {}
+    PendingFlag& operator=(PendingFlag&& F) {
+      store(F.load());
+      return *this;
+    }
+  };
+
+  // Modules are deserialized on demand even through const member functions,
+  // so these are mutable. Until every module is loaded, PendingMutex guards
+  // all of them, including Modules. HasPending is cleared once the last
+  // module is loaded, after which Modules is read without the lock.
+  mutable ModuleSet Modules;
+  mutable std::multimap<std::string, PendingModule> PendingModules;
+  mutable std::vector<UnresolvedReferent> UnresolvedReferents;
+  mutable bool LoadFailed = false;
+  mutable LoadMutex PendingMutex;
+  mutable PendingFlag HasPending;
 
   friend class Context;
 
@@ -266,6 +453,7 @@ private:
 /// \param M  The module to update.
 /// \param X  The name to use.
 inline void setModuleName(IR& Ir, Module& M, const std::string& X) {
+  Ir.loadPendingModules();
   auto& PointerView = Ir.Modules.get<IR::by_pointer>();
   auto it = PointerView.find(&M);
   if (it == PointerView.end())
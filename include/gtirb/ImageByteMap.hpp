@@ -361,6 +361,26 @@ public:
   /// \return The deserialized ImageByteMap object, or null on failure.
   static ImageByteMap* fromProtobuf(Context& C, const MessageType& Message);
 
+  /// \brief Add a region whose contents are held in externally owned memory.
+  ///
+  /// \sa ByteMap::addMappedRegion()
+  bool addMappedRegion(Addr A, const std::byte* Bytes, size_t Size) {
+    return BMap.addMappedRegion(A, Bytes, Size);
+  }
+
+  /// \brief Get the size of the serialized ImageByteMap message.
+  ///
+  /// \return The number of bytes writeProtobuf() will write.
+  size_t protobufSize() const;
+
+  /// \brief Serialize directly to a stream, without copying the image bytes
+  /// into a message.
+  ///
+  /// \param Out  The stream to write to.
+  ///
+  /// \return void
+  void writeProtobuf(google::protobuf::io::CodedOutputStream& Out) const;
+
   static bool classof(const Node* N) {
     return N->getKind() == Kind::ImageByteMap;
   }
@@ -0,0 +1,678 @@
+//===- IntervalIndex.hpp ----------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2018 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GTIRB_INTERVAL_INDEX_H
+#define GTIRB_INTERVAL_INDEX_H
+
+#include <gtirb/Addr.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/range/iterator_range.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <tuple>
+#include <vector>
+
+/// \file IntervalIndex.hpp
+/// \brief Class gtirb::IntervalIndex.
+
+namespace gtirb {
+
+/// \class IntervalIndex
+///
+/// \brief An index of objects by the address ranges they occupy, supporting
+/// queries for the objects containing an address or overlapping a range.
+///
+/// Each object occupies [getAddress(), addressLimit()) as of when it is
+/// inserted. An object's address and size must not change while it is in the
+/// index; erase it first, then insert it again.
+///
+/// The index is a binary search tree ordered by address, then by end
+/// address, in which each node also records the greatest end address in its
+/// subtree. Queries visit only subtrees which can hold a match, so finding
+/// the k objects overlapping a range takes O(log n + k) time for typical
+/// layouts, however much the objects overlap. Each object is stored once, so
+/// memory grows linearly. The tree is kept balanced by rebuilding any subtree
+/// which becomes too deep (a scapegoat tree), so insertion and erasure take
+/// amortized O(log n) time, and building from many objects at once takes a
+/// single sort. Nodes are stored in one array, in address order after a bulk
+/// build.
+///
+/// Once the index stops changing, buildPageTable() can add a table mapping
+/// each 4 KiB page to the objects covering it, in order. Finding the objects
+/// containing an address then takes a binary search within one page rather
+/// than a walk down the tree. The table is discarded when the index changes.
+///
+/// \tparam T  The type of the indexed objects.
+template <typename T> class IntervalIndex {
+  static constexpr uint32_t Nil = UINT32_MAX;
+
+  struct Node {
+    Addr Start;
+    Addr End;
+    // The greatest End in this node's subtree.
+    Addr MaxEnd;
+    T* Value;
+    uint32_t Left;
+    uint32_t Right;
+    uint32_t Parent;
+  };
+
+public:
+  /// \brief Iterator over the objects overlapping a query, in order of
+  /// address, then of end address.
+  class iterator
+      : public boost::iterator_facade<iterator, T* const,
+                                      boost::forward_traversal_tag> {
+  public:
+    iterator() = default;
+
+  private:
+    iterator(const IntervalIndex* I, uint32_t N, Addr L, Addr La)
+        : Index(I), Current(N), Lo(L), Last(La) {}
+    iterator(const IntervalIndex* I, const uint32_t* P, const uint32_t* PE,
+             Addr X)
+        : Index(I), Current(P == PE ? Nil : *P), Lo(X), Last(X), Page(P),
+          PageEnd(PE) {}
+
+    friend class boost::iterator_core_access;
+    friend class IntervalIndex;
+
+    T* const& dereference() const { return Index->Nodes[Current].Value; }
+    bool equal(const iterator& Other) const {
+      return Current == Other.Current;
+    }
+    void increment() {
+      if (!Page) {
+        Current = Index->next(Current, Lo, Last);
+        return;
+      }
+      // Skip the page's objects which end before the address.
+      do
+        ++Page;
+      while (Page != PageEnd && Index->Nodes[*Page].End <= Lo);
+      Current = Page == PageEnd ? Nil : *Page;
+    }
+
+    const IntervalIndex* Index{nullptr};
+    uint32_t Current{Nil};
+    // The query covers [Lo, Last].
+    Addr Lo;
+    Addr Last;
+    // For a query answered from the page table, the rest of the candidates.
+    const uint32_t* Page{nullptr};
+    const uint32_t* PageEnd{nullptr};
+  };
+
+  /// \brief Range of the objects overlapping a query.
+  using range = boost::iterator_range<iterator>;
+
+  /// \brief Create an empty index.
+  ///
+  /// \param Resource  The memory resource the index allocates from.
+  explicit IntervalIndex(
+      std::pmr::memory_resource* Resource = std::pmr::get_default_resource())
+      : Nodes(Resource), FreeNodes(Resource), PageLeaves(Resource),
+        PageNodes(Resource), PageMaxEnds(Resource) {}
+
+  /// \brief Add an object, which must not already be in the index.
+  ///
+  /// \param X  The object to add.
+  ///
+  /// \return void
+  void insert(T* X) {
+    dropPageTable();
+    Addr S = X->getAddress(), E = addressLimit(*X);
+    uint32_t N = newNode(S, E, X);
+    ++Count;
+    MaxCount = std::max(MaxCount, Count);
+    if (Root == Nil) {
+      Root = N;
+      return;
+    }
+
+    size_t Depth = 0;
+    uint32_t P = Root;
+    while (true) {
+      Node& Parent = Nodes[P];
+      Parent.MaxEnd = std::max(Parent.MaxEnd, E);
+      ++Depth;
+      uint32_t& Child = less(S, E, X, Parent) ? Parent.Left : Parent.Right;
+      if (Child == Nil) {
+        Child = N;
+        Nodes[N].Parent = P;
+        break;
+      }
+      P = Child;
+    }
+    if (Depth > maxDepth())
+      rebalanceAbove(N);
+  }
+
+  /// \brief Add several objects, none of which may already be in the index.
+  ///
+  /// If there are enough objects that inserting them one at a time would
+  /// cost more than rebuilding the whole index, the index is rebuilt once,
+  /// which is much faster. Objects already sorted by address and size are
+  /// not sorted again. A few objects added to a large index are inserted one
+  /// at a time instead.
+  ///
+  /// \param Begin  The start of the range of objects to add.
+  /// \param End    The end of the range of objects to add.
+  ///
+  /// \return void
+  template <typename InputIterator>
+  void insert(InputIterator Begin, InputIterator End) {
+    std::vector<T*> New(Begin, End);
+    size_t LogN = 1;
+    while ((size_t(1) << LogN) <= Count)
+      ++LogN;
+    if (New.size() * LogN < Count) {
+      for (T* X : New)
+        insert(X);
+      return;
+    }
+
+    dropPageTable();
+    std::vector<Node> All;
+    collect(All);
+    size_t Old = All.size();
+    for (T* X : New)
+      All.push_back({X->getAddress(), addressLimit(*X), Addr(), X, Nil, Nil,
+                     Nil});
+    // The existing nodes are already in order, and new objects often are
+    // too, so only sort and merge what is out of place.
+    auto Less = [](const Node& A, const Node& B) {
+      return less(A.Start, A.End, A.Value, B);
+    };
+    auto Mid = All.begin() + Old;
+    if (!std::is_sorted(Mid, All.end(), Less))
+      std::sort(Mid, All.end(), Less);
+    std::inplace_merge(All.begin(), Mid, All.end(), Less);
+    build(All);
+  }
+
+  /// \brief Remove an object. Its address and size must be the same as
+  /// when it was inserted.
+  ///
+  /// \param X  The object to remove.
+  ///
+  /// \return Whether the object was in the index.
+  bool erase(T* X) {
+    Addr S = X->getAddress(), E = addressLimit(*X);
+    uint32_t Z = Root;
+    while (Z != Nil && Nodes[Z].Value != X)
+      Z = less(S, E, X, Nodes[Z]) ? Nodes[Z].Left : Nodes[Z].Right;
+    if (Z == Nil)
+      return false;
+    dropPageTable();
+
+    // Move the next object into a node with two children, then remove the
+    // next object's node, which has no left child, instead.
+    if (Nodes[Z].Left != Nil && Nodes[Z].Right != Nil) {
+      uint32_t Y = Nodes[Z].Right;
+      while (Nodes[Y].Left != Nil)
+        Y = Nodes[Y].Left;
+      Nodes[Z].Start = Nodes[Y].Start;
+      Nodes[Z].End = Nodes[Y].End;
+      Nodes[Z].Value = Nodes[Y].Value;
+      Z = Y;
+    }
+
+    uint32_t Child = Nodes[Z].Left != Nil ? Nodes[Z].Left : Nodes[Z].Right;
+    uint32_t P = Nodes[Z].Parent;
+    if (Child != Nil)
+      Nodes[Child].Parent = P;
+    if (P == Nil)
+      Root = Child;
+    else if (Nodes[P].Left == Z)
+      Nodes[P].Left = Child;
+    else
+      Nodes[P].Right = Child;
+    FreeNodes.push_back(Z);
+    for (; P != Nil; P = Nodes[P].Parent)
+      updateMaxEnd(P);
+
+    // Rebuild once enough objects are gone that the tree may be too deep.
+    if (--Count * 3 < MaxCount * 2) {
+      std::vector<Node> All;
+      collect(All);
+      build(All);
+    }
+    return true;
+  }
+
+  /// \brief Remove every object.
+  ///
+  /// \return void
+  void clear() {
+    dropPageTable();
+    Nodes.clear();
+    FreeNodes.clear();
+    Root = Nil;
+    Count = MaxCount = 0;
+  }
+
+  /// \brief Get the number of objects in the index.
+  size_t size() const { return Count; }
+
+  /// \brief Check whether the index is empty.
+  bool empty() const { return Count == 0; }
+
+  /// \brief Find the objects containing an address.
+  ///
+  /// \param X  The address to look up.
+  ///
+  /// \return The objects containing \p X, in address order.
+  range find(Addr X) const {
+    if (PageLeaves.empty())
+      return query(X, X);
+
+    uint64_t Page = static_cast<uint64_t>(X) >> PageBits;
+    auto Leaf = std::lower_bound(
+        PageLeaves.begin(), PageLeaves.end(), Page >> LeafBits,
+        [](const PageLeaf& L, uint64_t Key) { return L.Key < Key; });
+    if (Leaf == PageLeaves.end() || Leaf->Key != Page >> LeafBits)
+      return range(iterator(), iterator());
+    size_t I = Page & (PagesPerLeaf - 1);
+    const uint32_t* Begin = PageNodes.data() + Leaf->Offsets[I];
+    const uint32_t* End = PageNodes.data() + Leaf->Offsets[I + 1];
+    const Addr* MaxEnds = PageMaxEnds.data() + Leaf->Offsets[I];
+
+    // The page's objects are in order, so the first to contain X is the first
+    // whose end, or that of an earlier one, lies after X, and the last to
+    // contain X is before the first which starts after X.
+    const Addr* First = std::upper_bound(MaxEnds, MaxEnds + (End - Begin), X);
+    Begin += First - MaxEnds;
+    End = std::partition_point(Begin, End, [this, X](uint32_t N) {
+      return Nodes[N].Start <= X;
+    });
+    return range(iterator(this, Begin, End, X), iterator());
+  }
+
+  /// \brief Find the objects overlapping a range of addresses.
+  ///
+  /// An object of size zero overlaps the range if its address lies strictly
+  /// within it.
+  ///
+  /// \param Lower  The start of the range.
+  /// \param Upper  The end of the range, which is not included.
+  ///
+  /// \return The objects overlapping [Lower, Upper), in address order.
+  range find(Addr Lower, Addr Upper) const {
+    if (Upper <= Lower)
+      return range(iterator(), iterator());
+    return query(Lower, Upper - 1);
+  }
+
+  /// \brief Find the objects containing each of a sorted sequence of
+  /// addresses.
+  ///
+  /// Rather than searching the tree for each address, this walks the objects
+  /// in order alongside the addresses, so it takes O(n + m) time for n
+  /// objects and m addresses. When there are too few addresses for that to
+  /// pay off, each address is looked up separately instead.
+  ///
+  /// \param Begin  The start of the addresses, in ascending order.
+  /// \param End    The end of the addresses.
+  /// \param F      Called with the position of each address in the sequence
+  ///               and the range of objects containing it, in order.
+  ///
+  /// \return void
+  template <typename FunctionTy>
+  void findSorted(const Addr* Begin, const Addr* End, FunctionTy F) const {
+    assert(std::is_sorted(Begin, End) && "addresses must be sorted");
+    size_t M = static_cast<size_t>(End - Begin);
+    if (M == 0)
+      return;
+    size_t LogN = 1;
+    while ((size_t(1) << LogN) <= Count)
+      ++LogN;
+    if (!PageLeaves.empty() || M * LogN < Count) {
+      for (size_t I = 0; I < M; ++I)
+        F(I, find(Begin[I]));
+      return;
+    }
+
+    // The first object containing X, if any, is the first object to end
+    // after X, since every earlier one ends by X. Track the greatest end of
+    // the objects walked so far to find that object for each address.
+    uint32_t N = firstEndingAfter(Begin[0]);
+    Addr MaxEnd = N == Nil ? Addr() : Nodes[N].End;
+    for (size_t I = 0; I < M; ++I) {
+      Addr X = Begin[I];
+      while (N != Nil && MaxEnd <= X) {
+        N = successor(N);
+        if (N != Nil)
+          MaxEnd = std::max(MaxEnd, Nodes[N].End);
+      }
+      if (N != Nil && Nodes[N].Start <= X)
+        F(I, range(iterator(this, N, X, X), iterator(this, Nil, X, X)));
+      else
+        F(I, range(iterator(), iterator()));
+    }
+  }
+
+  /// \brief Build a table mapping pages to the objects covering them, to
+  /// speed up finding the objects containing an address.
+  ///
+  /// The table is discarded when the index next changes. It is not built if
+  /// it would be too large, as when objects span far more pages than there
+  /// are objects.
+  ///
+  /// \return Whether the table was built.
+  bool buildPageTable() {
+    dropPageTable();
+    std::vector<uint32_t> Order;
+    flatten(Root, Order);
+
+    // Objects of size zero contain no address, so they are left out.
+    auto FirstPage = [this](uint32_t N) {
+      return static_cast<uint64_t>(Nodes[N].Start) >> PageBits;
+    };
+    auto LastPage = [this](uint32_t N) {
+      return (static_cast<uint64_t>(Nodes[N].End) - 1) >> PageBits;
+    };
+    Order.erase(std::remove_if(Order.begin(), Order.end(),
+                               [this](uint32_t N) {
+                                 return Nodes[N].End <= Nodes[N].Start;
+                               }),
+                Order.end());
+    uint64_t Entries = 0;
+    for (uint32_t N : Order)
+      Entries += LastPage(N) - FirstPage(N) + 1;
+    if (Order.empty() || Entries > 8 * Order.size() + PagesPerLeaf ||
+        Entries >= Nil)
+      return false;
+
+    std::vector<uint64_t> Keys;
+    for (uint32_t N : Order)
+      for (uint64_t K = FirstPage(N) >> LeafBits,
+                    E = LastPage(N) >> LeafBits;
+           K <= E; ++K)
+        if (Keys.empty() || Keys.back() != K)
+          Keys.push_back(K);
+    std::sort(Keys.begin(), Keys.end());
+    Keys.erase(std::unique(Keys.begin(), Keys.end()), Keys.end());
+    PageLeaves.resize(Keys.size());
+    for (size_t I = 0; I < Keys.size(); ++I)
+      PageLeaves[I].Key = Keys[I];
+
+    // Count each page's objects, then lay the pages out one after another.
+    auto ForEachPage = [&](uint32_t N, auto F) {
+      uint64_t P = FirstPage(N), E = LastPage(N);
+      auto Leaf = std::lower_bound(Keys.begin(), Keys.end(), P >> LeafBits);
+      for (; P <= E; ++P) {
+        if ((P & (PagesPerLeaf - 1)) == 0 && P != FirstPage(N))
+          ++Leaf;
+        F(PageLeaves[Leaf - Keys.begin()], P & (PagesPerLeaf - 1));
+      }
+    };
+    for (uint32_t N : Order)
+      ForEachPage(N, [](PageLeaf& L, size_t I) { ++L.Offsets[I + 1]; });
+    uint32_t Total = 0;
+    for (PageLeaf& L : PageLeaves) {
+      L.Offsets[0] = Total;
+      for (size_t I = 1; I <= PagesPerLeaf; ++I)
+        L.Offsets[I] = Total += L.Offsets[I];
+    }
+    std::vector<uint32_t> Filled(PageLeaves.size() * PagesPerLeaf);
+    PageNodes.resize(Total);
+    for (uint32_t N : Order)
+      ForEachPage(N, [&](PageLeaf& L, size_t I) {
+        size_t Slot = (&L - PageLeaves.data()) * PagesPerLeaf + I;
+        PageNodes[L.Offsets[I] + Filled[Slot]++] = N;
+      });
+
+    // Record the greatest end so far within each page.
+    PageMaxEnds.resize(Total);
+    for (const PageLeaf& L : PageLeaves) {
+      for (size_t I = 0; I < PagesPerLeaf; ++I) {
+        Addr Max;
+        for (uint32_t J = L.Offsets[I]; J < L.Offsets[I + 1]; ++J)
+          PageMaxEnds[J] = Max = std::max(Max, Nodes[PageNodes[J]].End);
+      }
+    }
+    return true;
+  }
+
+  /// \brief Check whether the index has a page table.
+  bool hasPageTable() const { return !PageLeaves.empty(); }
+
+private:
+  // Pages are 4 KiB, and each leaf of the page table covers 1024 of them.
+  static constexpr unsigned PageBits = 12;
+  static constexpr unsigned LeafBits = 10;
+  static constexpr size_t PagesPerLeaf = size_t(1) << LeafBits;
+
+  struct PageLeaf {
+    // The address of the leaf's first page, shifted right by PageBits and
+    // LeafBits.
+    uint64_t Key{0};
+    // Page I's objects are PageNodes[Offsets[I]] to PageNodes[Offsets[I+1]].
+    uint32_t Offsets[PagesPerLeaf + 1]{};
+  };
+
+  void dropPageTable() {
+    PageLeaves.clear();
+    PageNodes.clear();
+    PageMaxEnds.clear();
+  }
+
+  // Order nodes by address, then end address, then by object, so every key
+  // is distinct.
+  static bool less(Addr S, Addr E, T* X, const Node& N) {
+    return std::tie(S, E) < std::tie(N.Start, N.End) ||
+           (S == N.Start && E == N.End && std::less<T*>()(X, N.Value));
+  }
+
+  uint32_t newNode(Addr S, Addr E, T* X) {
+    Node N{S, E, E, X, Nil, Nil, Nil};
+    if (!FreeNodes.empty()) {
+      uint32_t I = FreeNodes.back();
+      FreeNodes.pop_back();
+      Nodes[I] = N;
+      return I;
+    }
+    assert(Nodes.size() < Nil && "too many objects in interval index");
+    Nodes.push_back(N);
+    return static_cast<uint32_t>(Nodes.size() - 1);
+  }
+
+  void updateMaxEnd(uint32_t N) {
+    Node& Current = Nodes[N];
+    Current.MaxEnd = Current.End;
+    if (Current.Left != Nil)
+      Current.MaxEnd = std::max(Current.MaxEnd, Nodes[Current.Left].MaxEnd);
+    if (Current.Right != Nil)
+      Current.MaxEnd = std::max(Current.MaxEnd, Nodes[Current.Right].MaxEnd);
+  }
+
+  // The depth beyond which a node's ancestors must include one whose
+  // subtree is out of balance: log base 3/2 of the number of objects.
+  size_t maxDepth() const {
+    return static_cast<size_t>(std::log(static_cast<double>(Count)) /
+                               std::log(1.5));
+  }
+
+  size_t subtreeSize(uint32_t N) const {
+    if (N == Nil)
+      return 0;
+    return 1 + subtreeSize(Nodes[N].Left) + subtreeSize(Nodes[N].Right);
+  }
+
+  // Rebuild the subtree of the lowest ancestor of a too-deep node which has
+  // a child holding more than 2/3 of its subtree.
+  void rebalanceAbove(uint32_t N) {
+    size_t Size = 1;
+    for (uint32_t P = Nodes[N].Parent; P != Nil; N = P, P = Nodes[P].Parent) {
+      uint32_t Sibling = Nodes[P].Left == N ? Nodes[P].Right : Nodes[P].Left;
+      size_t ParentSize = Size + 1 + subtreeSize(Sibling);
+      if (3 * Size > 2 * ParentSize) {
+        rebuildSubtree(P);
+        return;
+      }
+      Size = ParentSize;
+    }
+  }
+
+  void flatten(uint32_t N, std::vector<uint32_t>& Order) const {
+    if (N == Nil)
+      return;
+    flatten(Nodes[N].Left, Order);
+    Order.push_back(N);
+    flatten(Nodes[N].Right, Order);
+  }
+
+  // Link the nodes Order[Begin, End) into a balanced subtree.
+  uint32_t link(const std::vector<uint32_t>& Order, size_t Begin, size_t End,
+                uint32_t Parent) {
+    if (Begin == End)
+      return Nil;
+    size_t Mid = Begin + (End - Begin) / 2;
+    uint32_t N = Order[Mid];
+    Nodes[N].Parent = Parent;
+    Nodes[N].Left = link(Order, Begin, Mid, N);
+    Nodes[N].Right = link(Order, Mid + 1, End, N);
+    updateMaxEnd(N);
+    return N;
+  }
+
+  void rebuildSubtree(uint32_t N) {
+    uint32_t Parent = Nodes[N].Parent;
+    std::vector<uint32_t> Order;
+    flatten(N, Order);
+    uint32_t NewRoot = link(Order, 0, Order.size(), Parent);
+    if (Parent == Nil)
+      Root = NewRoot;
+    else if (Nodes[Parent].Left == N)
+      Nodes[Parent].Left = NewRoot;
+    else
+      Nodes[Parent].Right = NewRoot;
+  }
+
+  // Copy out every object's node, in order.
+  void collect(std::vector<Node>& All) const {
+    std::vector<uint32_t> Order;
+    flatten(Root, Order);
+    All.reserve(All.size() + Order.size());
+    for (uint32_t N : Order)
+      All.push_back(Nodes[N]);
+  }
+
+  // Replace the tree with a balanced one holding the sorted nodes All, laid
+  // out in order.
+  void build(const std::vector<Node>& All) {
+    Nodes.assign(All.begin(), All.end());
+    FreeNodes.clear();
+    std::vector<uint32_t> Order(Nodes.size());
+    for (size_t I = 0; I < Order.size(); ++I)
+      Order[I] = static_cast<uint32_t>(I);
+    Root = link(Order, 0, Order.size(), Nil);
+    Count = MaxCount = Nodes.size();
+  }
+
+  range query(Addr Lo, Addr Last) const {
+    return range(iterator(this, first(Root, Lo, Last), Lo, Last),
+                 iterator(this, Nil, Lo, Last));
+  }
+
+  // Find the first node in N's subtree overlapping [Lo, Last].
+  uint32_t first(uint32_t N, Addr Lo, Addr Last) const {
+    while (N != Nil && Nodes[N].MaxEnd > Lo) {
+      // If anything on the left ends after Lo, either it is a match or
+      // nothing here starts early enough.
+      uint32_t L = Nodes[N].Left;
+      if (L != Nil && Nodes[L].MaxEnd > Lo) {
+        N = L;
+        continue;
+      }
+      if (Nodes[N].Start > Last)
+        return Nil;
+      if (Nodes[N].End > Lo)
+        return N;
+      N = Nodes[N].Right;
+    }
+    return Nil;
+  }
+
+  // Find the first node, in order, which ends after X.
+  uint32_t firstEndingAfter(Addr X) const {
+    uint32_t N = Root;
+    while (N != Nil && Nodes[N].MaxEnd > X) {
+      uint32_t L = Nodes[N].Left;
+      if (L != Nil && Nodes[L].MaxEnd > X)
+        N = L;
+      else if (Nodes[N].End > X)
+        return N;
+      else
+        N = Nodes[N].Right;
+    }
+    return Nil;
+  }
+
+  // Find the node after N in order.
+  uint32_t successor(uint32_t N) const {
+    if (uint32_t R = Nodes[N].Right; R != Nil) {
+      while (Nodes[R].Left != Nil)
+        R = Nodes[R].Left;
+      return R;
+    }
+    uint32_t P = Nodes[N].Parent;
+    while (P != Nil && Nodes[P].Right == N) {
+      N = P;
+      P = Nodes[P].Parent;
+    }
+    return P;
+  }
+
+  // Find the first node after N overlapping [Lo, Last].
+  uint32_t next(uint32_t N, Addr Lo, Addr Last) const {
+    if (uint32_t Found = first(Nodes[N].Right, Lo, Last); Found != Nil)
+      return Found;
+    for (uint32_t P = Nodes[N].Parent; P != Nil; N = P, P = Nodes[P].Parent) {
+      if (Nodes[P].Left != N)
+        continue;
+      if (Nodes[P].Start > Last)
+        return Nil;
+      if (Nodes[P].End > Lo)
+        return P;
+      if (uint32_t Found = first(Nodes[P].Right, Lo, Last); Found != Nil)
+        return Found;
+    }
+    return Nil;
+  }
+
+  std::pmr::vector<Node> Nodes;
+  // Nodes freed by erase(), to be reused by insert().
+  std::pmr::vector<uint32_t> FreeNodes;
+  uint32_t Root{Nil};
+  size_t Count{0};
+  // The greatest Count since the tree was last rebuilt.
+  size_t MaxCount{0};
+  // The page table, sorted by key, if one has been built.
+  std::pmr::vector<PageLeaf> PageLeaves;
+  // The objects covering each page, in order.
+  std::pmr::vector<uint32_t> PageNodes;
+  // For each entry of PageNodes, the greatest end of it and the earlier
+  // objects covering the same page.
+  std::pmr::vector<Addr> PageMaxEnds;
+};
+
+} // namespace gtirb
+
+#endif // GTIRB_INTERVAL_INDEX_H
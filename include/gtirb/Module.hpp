@@ -21,13 +21,13 @@
 #include <gtirb/DataObject.hpp>
 #include <gtirb/Export.hpp>
 #include <gtirb/ImageByteMap.hpp>
+#include <gtirb/IntervalIndex.hpp>
 #include <gtirb/Node.hpp>
 #include <gtirb/Section.hpp>
 #include <gtirb/Symbol.hpp>
 #include <gtirb/SymbolicExpression.hpp>
 #include <proto/Module.pb.h>
 #include <algorithm>
-#include <boost/icl/interval_map.hpp>
 #include <boost/iterator/indirect_iterator.hpp>
 #include <boost/iterator/iterator_traits.hpp>
 #include <boost/iterator/transform_iterator.hpp>
@@ -39,14 +39,21 @@
 #include <boost/range/iterator_range.hpp>
 #include <cstdint>
 #include <functional>
+#include <limits>
+#include <memory_resource>
 #include <optional>
+#include <set>
 #include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 /// \file Module.hpp
 /// \brief Class gtirb::Module and related functions and types.
 
 namespace gtirb {
 class IR;
+class UUIDTable;
 
 /// \enum FileFormat
 ///
@@ -89,10 +96,33 @@ class GTIRB_EXPORT_API Module : public AuxDataContainer {
   struct by_address {};
   struct by_name {};
   struct by_pointer {};
+  struct by_name_hash {};
+  struct by_referent {};
 
   // Helper template for implementing address-based ordering of
   // multi-containers.
 
+  struct addr_hash {
+    size_t operator()(Addr A) const {
+      return std::hash<uint64_t>()(static_cast<uint64_t>(A));
+    }
+  };
+
+  // Symbol names are interned, so a name is identified by the address of its
+  // interned string.
+  struct interned_name {
+    using result_type = const std::string*;
+    result_type operator()(const Symbol* S) const { return &S->getName(); }
+  };
+
+  // The referent of a symbol, or null for symbols with none.
+  struct referent {
+    using result_type = const Node*;
+    result_type operator()(const Symbol* S) const {
+      return S->getReferent<Node>();
+    }
+  };
+
   template <typename T> struct addr_size_order {
     static std::pair<Addr, uint64_t> key(const T& t) {
       return std::make_pair(t.getAddress(), t.getSize());
@@ -102,6 +132,9 @@ class GTIRB_EXPORT_API Module : public AuxDataContainer {
     }
   };
 
+  // The containers below allocate from the Context's memory resource, so
+  // their memory sits alongside the nodes and is released with the Context.
+
   // Multiset of Blocks that enforces:
   //  - iteration in order of address followed by size
   //  - uniqueness of contained objects
@@ -114,11 +147,10 @@ class GTIRB_EXPORT_API Module : public AuxDataContainer {
                           &addr_size_order<Block>::key>>,
                   boost::multi_index::hashed_unique<
                       boost::multi_index::tag<by_pointer>,
-                      boost::multi_index::identity<Block*>>>>;
-  // Interval map to support querying Blocks by a contained address.
-  using BlockIntMap =
-      boost::icl::interval_map<Addr,
-                               std::multiset<Block*, addr_size_order<Block>>>;
+                      boost::multi_index::identity<Block*>>>,
+      std::pmr::polymorphic_allocator<Block*>>;
+  // Index to support querying Blocks by a contained address.
+  using BlockAddrIndex = IntervalIndex<Block>;
 
   using DataSet = boost::multi_index::multi_index_container<
       DataObject*, boost::multi_index::indexed_by<
@@ -129,11 +161,11 @@ class GTIRB_EXPORT_API Module : public AuxDataContainer {
                                &addr_size_order<DataObject>::key>>,
                        boost::multi_index::hashed_unique<
                            boost::multi_index::tag<by_pointer>,
-                           boost::multi_index::identity<DataObject*>>>>;
-  using DataIntMap = boost::icl::interval_map<
-      Addr, std::multiset<DataObject*, addr_size_order<DataObject>>>;
+                           boost::multi_index::identity<DataObject*>>>,
+      std::pmr::polymorphic_allocator<DataObject*>>;
+  using DataAddrIndex = IntervalIndex<DataObject>;
 
-  using ProxyBlockSet = std::unordered_set<ProxyBlock*>;
+  using ProxyBlockSet = std::pmr::unordered_set<ProxyBlock*>;
 
   using SectionSet = boost::multi_index::multi_index_container<
       Section*, boost::multi_index::indexed_by<
@@ -148,9 +180,9 @@ class GTIRB_EXPORT_API Module : public AuxDataContainer {
                             Section, const std::string&, &Section::getName>>,
                     boost::multi_index::hashed_unique<
                         boost::multi_index::tag<by_pointer>,
-                        boost::multi_index::identity<Section*>>>>;
-  using SectionIntMap = boost::icl::interval_map<
-      Addr, std::multiset<Section*, addr_size_order<Section>>>;
+                        boost::multi_index::identity<Section*>>>,
+      std::pmr::polymorphic_allocator<Section*>>;
+  using SectionAddrIndex = IntervalIndex<Section>;
 
   using SymbolSet = boost::multi_index::multi_index_container<
       Symbol*, boost::multi_index::indexed_by<
@@ -164,7 +196,12 @@ class GTIRB_EXPORT_API Module : public AuxDataContainer {
                            Symbol, const std::string&, &Symbol::getName>>,
                    boost::multi_index::hashed_unique<
                        boost::multi_index::tag<by_pointer>,
-                       boost::multi_index::identity<Symbol*>>>>;
+                       boost::multi_index::identity<Symbol*>>,
+                   boost::multi_index::hashed_non_unique<
+                       boost::multi_index::tag<by_name_hash>, interned_name>,
+                   boost::multi_index::hashed_non_unique<
+                       boost::multi_index::tag<by_referent>, referent>>,
+      std::pmr::polymorphic_allocator<Symbol*>>;
 
   using SymbolicExpressionElement = std::pair<Addr, SymbolicExpression>;
   using SymbolicExpressionSet = boost::multi_index::multi_index_container<
@@ -176,7 +213,17 @@ class GTIRB_EXPORT_API Module : public AuxDataContainer {
           boost::multi_index::hashed_non_unique<
               BOOST_MULTI_INDEX_MEMBER(SymbolicExpressionElement,
                                        SymbolicExpression, second),
-              std::hash<SymbolicExpression>>>>;
+              std::hash<SymbolicExpression>>,
+          // Finds a symbolic expression by address in constant time.
+          boost::multi_index::hashed_unique<
+              BOOST_MULTI_INDEX_MEMBER(SymbolicExpressionElement, Addr, first),
+              addr_hash>>,
+      std::pmr::polymorphic_allocator<SymbolicExpressionElement>>;
+
+  // Reverse index from each Symbol to the addresses of the symbolic
+  // expressions which mention it, kept in sync with SymbolicOperands.
+  using SymbolReference = std::pair<const Symbol*, Addr>;
+  using SymbolReferenceSet = std::pmr::set<SymbolReference>;
 
   Module(Context& C);
   Module(Context& C, const std::string& X);
@@ -187,6 +234,26 @@ class GTIRB_EXPORT_API Module : public AuxDataContainer {
     }
   };
 
+  // Find the symbols with the interned name Name in the by_name index,
+  // starting from the one the hashed index finds. Name is null if no symbol
+  // has the name.
+  template <typename SetTy>
+  static auto findByName(SetTy& Set, const std::string* Name) {
+    auto& ByName = Set.template get<by_name>();
+    const auto& ByHash = Set.template get<by_name_hash>();
+    auto Hit = Name ? ByHash.find(Name) : ByHash.end();
+    if (Hit == ByHash.end())
+      return std::make_pair(ByName.end(), ByName.end());
+    auto Named = [Name](const Symbol* S) { return &S->getName() == Name; };
+    auto First = Set.template project<by_name>(Hit);
+    auto Last = std::next(First);
+    while (First != ByName.begin() && Named(*std::prev(First)))
+      --First;
+    while (Last != ByName.end() && Named(*Last))
+      ++Last;
+    return std::make_pair(First, Last);
+  }
+
 public:
   /// \brief Create a Module object in its default state.
   ///
@@ -305,6 +372,38 @@ public:
     addVertex(P, getCFG());
   }
 
+  /// \brief Add a range of ProxyBlocks to the module.
+  ///
+  /// \param Begin  The start of the range of ProxyBlocks to add.
+  /// \param End    The end of the range of ProxyBlocks to add.
+  ///
+  /// \return void
+  template <typename InputIterator>
+  void addProxyBlocks(InputIterator Begin, InputIterator End) {
+    insertProxyBlocks(std::vector<ProxyBlock*>(Begin, End));
+  }
+
+  /// \brief Remove a ProxyBlock from the module, along with its CFG edges.
+  ///
+  /// The ProxyBlock is not destroyed, and may be added to a module again.
+  /// Symbols referring to it no longer have a referent.
+  ///
+  /// \param P  The ProxyBlock to remove.
+  ///
+  /// \return Whether the ProxyBlock was in the module.
+  bool removeProxyBlock(ProxyBlock* P);
+
+  /// \brief Remove a ProxyBlock from the module, along with its CFG edges,
+  /// and destroy it.
+  ///
+  /// If the ProxyBlock is not in the module, nothing happens. Symbols
+  /// referring to it no longer have a referent.
+  ///
+  /// \param P  The ProxyBlock to erase.
+  ///
+  /// \return void
+  void eraseProxyBlock(ProxyBlock* P);
+
   /// \name Symbol-Related Public Types and Functions
   /// @{
 
@@ -332,6 +431,27 @@ public:
   /// name, their order is unspecified.
   using const_symbol_range = boost::iterator_range<const_symbol_iterator>;
 
+  /// \brief Iterator over symbols (\ref Symbol) with the same referent.
+  ///
+  /// The order of the symbols is unspecified.
+  using symbol_ref_iterator = boost::indirect_iterator<
+      SymbolSet::index<by_referent>::type::iterator>;
+  /// \brief Range of symbols (\ref Symbol) with the same referent.
+  ///
+  /// The order of the symbols is unspecified.
+  using symbol_ref_range = boost::iterator_range<symbol_ref_iterator>;
+  /// \brief Constant iterator over symbols (\ref Symbol) with the same
+  /// referent.
+  ///
+  /// The order of the symbols is unspecified.
+  using const_symbol_ref_iterator = boost::indirect_iterator<
+      SymbolSet::index<by_referent>::type::const_iterator, const Symbol>;
+  /// \brief Constant range of symbols (\ref Symbol) with the same referent.
+  ///
+  /// The order of the symbols is unspecified.
+  using const_symbol_ref_range =
+      boost::iterator_range<const_symbol_ref_iterator>;
+
   /// \brief Iterator over symbols (\ref Symbol).
   ///
   /// This iterator returns symbols in address order. If two Symbols have the
@@ -400,15 +520,43 @@ public:
     }
   }
 
+  /// \brief Remove a symbol from the module.
+  ///
+  /// The symbol is not destroyed, and may be added to a module again.
+  /// Symbolic expressions referring to it stay in the module, and are still
+  /// found by getSymbolicExpressionAddrs().
+  ///
+  /// \param S The Symbol object to remove.
+  ///
+  /// \return Whether the symbol was in the module.
+  bool removeSymbol(Symbol* S);
+
+  /// \brief Remove a symbol from the module and destroy it.
+  ///
+  /// If the symbol is not in the module, nothing happens. Symbolic
+  /// expressions referring to it are removed from the module.
+  ///
+  /// \param S The Symbol object to erase.
+  ///
+  /// \return void
+  void eraseSymbol(Symbol* S);
+
   /// \brief Find symbols by name
   ///
   /// \param N The name to look up.
   ///
   /// \return A possibly empty range of all the symbols with the
   /// given name.
+  ///
+  /// This looks \p N up once among the Context's interned strings, finds
+  /// one of the symbols by the address of the interned name, then collects
+  /// the rest from their neighbors in name order. No strings are compared
+  /// after the first lookup.
   symbol_range findSymbols(const std::string& N) {
-    auto Found = Symbols.get<by_name>().equal_range(N);
-    return boost::make_iterator_range(Found.first, Found.second);
+    auto [First, Last] =
+        findByName(Symbols, getContext().findInternedString(N));
+    return boost::make_iterator_range(symbol_iterator(First),
+                                      symbol_iterator(Last));
   }
 
   /// \brief Find symbols by name
@@ -418,8 +566,10 @@ public:
   /// \return A possibly empty constant range of all the symbols with the
   /// given name.
   const_symbol_range findSymbols(const std::string& N) const {
-    auto Found = Symbols.get<by_name>().equal_range(N);
-    return boost::make_iterator_range(Found.first, Found.second);
+    auto [First, Last] =
+        findByName(Symbols, getContext().findInternedString(N));
+    return boost::make_iterator_range(const_symbol_iterator(First),
+                                      const_symbol_iterator(Last));
   }
 
   /// \brief Find symbols by address.
@@ -444,6 +594,31 @@ public:
     return boost::make_iterator_range(Found.first, Found.second);
   }
 
+  /// \brief Find symbols by referent.
+  ///
+  /// \param N The referent to look up, such as a Block or DataObject.
+  ///
+  /// \return A possibly empty range of all the symbols referring to \p N.
+  ///
+  /// The symbols are found by hashing, without scanning every symbol. The
+  /// index follows changes made through setReferent() and
+  /// setSymbolAddress().
+  symbol_ref_range findSymbols(const Node& N) {
+    auto Found = Symbols.get<by_referent>().equal_range(&N);
+    return boost::make_iterator_range(Found.first, Found.second);
+  }
+
+  /// \brief Find symbols by referent.
+  ///
+  /// \param N The referent to look up, such as a Block or DataObject.
+  ///
+  /// \return A possibly empty constant range of all the symbols referring to
+  /// \p N.
+  const_symbol_ref_range findSymbols(const Node& N) const {
+    auto Found = Symbols.get<by_referent>().equal_range(&N);
+    return boost::make_iterator_range(Found.first, Found.second);
+  }
+
   /// \brief Find symbols by a range of addresses.
   ///
   /// \param Lower The lower-bounded address to look up.
@@ -469,6 +644,29 @@ public:
         Symbols.get<by_address>().lower_bound(Lower),
         Symbols.get<by_address>().lower_bound(Upper));
   }
+
+  /// \brief Find the symbols at each of a sorted sequence of addresses.
+  ///
+  /// This walks the symbols once in address order alongside the addresses,
+  /// instead of searching for each address.
+  ///
+  /// \param Sorted      The addresses to look up, in ascending order.
+  /// \param NumThreads  The number of threads to divide the addresses among.
+  ///
+  /// \return The range of symbols at each address, in the same order as
+  /// \p Sorted.
+  std::vector<symbol_addr_range> findSymbols(const std::vector<Addr>& Sorted,
+                                             unsigned NumThreads = 1);
+
+  /// \brief Find the symbols at each of a sorted sequence of addresses.
+  ///
+  /// \param Sorted      The addresses to look up, in ascending order.
+  /// \param NumThreads  The number of threads to divide the addresses among.
+  ///
+  /// \return The constant range of symbols at each address, in the same
+  /// order as \p Sorted.
+  std::vector<const_symbol_addr_range>
+  findSymbols(const std::vector<Addr>& Sorted, unsigned NumThreads = 1) const;
   /// @}
   // (end group of symbol-related type aliases and functions)
 
@@ -503,13 +701,14 @@ public:
   /// address, the smaller one is returned first. If two blocks have the same
   /// address and the same size, their order is not specified.
   using block_range = boost::iterator_range<block_iterator>;
-  /// \brief Sub-range of blocks overlapping an address (\ref Block).
+  /// \brief Sub-range of blocks overlapping an address or address range
+  /// (\ref Block).
   ///
   /// Blocks are returned in address order. If two blocks start at the same
   /// address, the smaller one is returned first. If two blocks have the same
   /// address and the same size, their order is not specified.
   using block_subrange = boost::iterator_range<
-      boost::indirect_iterator<BlockIntMap::codomain_type::iterator>>;
+      boost::indirect_iterator<BlockAddrIndex::iterator>>;
   /// \brief Constant iterator over blocks (\ref Block).
   ///
   /// Blocks are returned in address order. If two blocks start at the same
@@ -523,13 +722,14 @@ public:
   /// address, the smaller one is returned first. If two blocks have the same
   /// address and the same size, their order is not specified.
   using const_block_range = boost::iterator_range<const_block_iterator>;
-  /// \brief Constant sub-range of blocks overlapping an address (\ref Block).
+  /// \brief Constant sub-range of blocks overlapping an address or address
+  /// range (\ref Block).
   ///
   /// Blocks are returned in address order. If two blocks start at the same
   /// address, the smaller one is returned first. If two blocks have the same
   /// address and the same size, their order is not specified.
-  using const_block_subrange = boost::iterator_range<boost::indirect_iterator<
-      BlockIntMap::codomain_type::const_iterator, const Block&>>;
+  using const_block_subrange = boost::iterator_range<
+      boost::indirect_iterator<BlockAddrIndex::iterator, const Block&>>;
 
   /// \brief Return an iterator to the first Block.
   block_iterator block_begin() { return block_iterator(Blocks.begin()); }
@@ -563,24 +763,58 @@ public:
   void addBlocks(std::initializer_list<Block*> Bs) {
     for (Block* B : Bs) {
       if (Blocks.emplace(B).second) {
-        BlockAddrs.add(std::make_pair(BlockIntMap::interval_type::right_open(
-                                          B->getAddress(), addressLimit(*B)),
-                                      BlockIntMap::codomain_type{B}));
+        BlockAddrs.insert(B);
         addVertex(B, Cfg);
       }
     }
   }
 
+  /// \brief Add a range of blocks to the module.
+  ///
+  /// The blocks are sorted once and each index is updated in address order,
+  /// rebuilding the address index when the range is large compared to the
+  /// blocks already in the module. This is much faster than adding many
+  /// blocks one at a time. It is fastest when the blocks are sorted by
+  /// address and size.
+  ///
+  /// \param Begin  The start of the range of Block objects to add.
+  /// \param End    The end of the range of Block objects to add.
+  ///
+  /// \return void
+  template <typename InputIterator>
+  void addBlocks(InputIterator Begin, InputIterator End) {
+    insertBlocks(std::vector<Block*>(Begin, End));
+  }
+
+  /// \brief Remove a block from the module, along with its CFG edges.
+  ///
+  /// The block is not destroyed, and may be added to a module again. Every
+  /// index is updated in logarithmic time, and the CFG in time proportional
+  /// to the number of edges removed. Symbols referring to the block keep its
+  /// address but no longer have a referent.
+  ///
+  /// \param B  The Block object to remove.
+  ///
+  /// \return Whether the block was in the module.
+  bool removeBlock(Block* B);
+
+  /// \brief Remove a block from the module, along with its CFG edges, and
+  /// destroy it.
+  ///
+  /// If the block is not in the module, nothing happens. Symbols referring
+  /// to it keep its address but no longer have a referent.
+  ///
+  /// \param B  The Block object to erase.
+  void eraseBlock(Block* B);
+
   /// \brief Find a Block containing an address.
   ///
   /// \param X  The address to look up.
   ///
   /// \return The range of Blocks containing the address.
   block_subrange findBlock(Addr X) {
-    auto it = BlockAddrs.find(X);
-    if (it == BlockAddrs.end())
-      return {};
-    return boost::make_iterator_range(it->second.begin(), it->second.end());
+    auto Found = BlockAddrs.find(X);
+    return boost::make_iterator_range(Found.begin(), Found.end());
   }
 
   /// \brief Find a Block containing an address.
@@ -589,11 +823,64 @@ public:
   ///
   /// \return The range of Blocks containing the address.
   const_block_subrange findBlock(Addr X) const {
-    auto it = BlockAddrs.find(X);
-    if (it == BlockAddrs.end())
-      return {};
-    return boost::make_iterator_range(it->second.begin(), it->second.end());
+    auto Found = BlockAddrs.find(X);
+    return boost::make_iterator_range(Found.begin(), Found.end());
+  }
+
+  /// \brief Find the Blocks overlapping a range of addresses.
+  ///
+  /// The Blocks are found by walking the address index as the range is
+  /// iterated, so only the overlapping Blocks are visited. One of size zero
+  /// overlaps the range if its address lies strictly within it.
+  ///
+  /// \param Lower The start of the range.
+  /// \param Upper The end of the range, which is not included.
+  ///
+  /// \return The range of Blocks overlapping [Lower, Upper).
+  block_subrange findBlocks(Addr Lower, Addr Upper) {
+    auto Found = BlockAddrs.find(Lower, Upper);
+    return boost::make_iterator_range(Found.begin(), Found.end());
   }
+
+  /// \brief Find the Blocks overlapping a range of addresses.
+  ///
+  /// The Blocks are found by walking the address index as the range is
+  /// iterated, so only the overlapping Blocks are visited. One of size zero
+  /// overlaps the range if its address lies strictly within it.
+  ///
+  /// \param Lower The start of the range.
+  /// \param Upper The end of the range, which is not included.
+  ///
+  /// \return The constant range of Blocks overlapping [Lower, Upper).
+  const_block_subrange findBlocks(Addr Lower, Addr Upper) const {
+    auto Found = BlockAddrs.find(Lower, Upper);
+    return boost::make_iterator_range(Found.begin(), Found.end());
+  }
+
+  /// \brief Find the Blocks containing each of a sorted sequence of
+  /// addresses.
+  ///
+  /// This walks the address index once alongside the addresses, instead of
+  /// searching it for each address.
+  ///
+  /// \param Sorted      The addresses to look up, in ascending order.
+  /// \param NumThreads  The number of threads to divide the addresses among.
+  ///
+  /// \return The range of Blocks containing each address, in the same order
+  /// as \p Sorted.
+  std::vector<block_subrange> findBlocks(const std::vector<Addr>& Sorted,
+                                         unsigned NumThreads = 1);
+
+  /// \brief Find the Blocks containing each of a sorted sequence of
+  /// addresses.
+  ///
+  /// \param Sorted      The addresses to look up, in ascending order.
+  /// \param NumThreads  The number of threads to divide the addresses among.
+  ///
+  /// \return The constant range of Blocks containing each address, in the
+  /// same order as \p Sorted.
+  std::vector<const_block_subrange>
+  findBlocks(const std::vector<Addr>& Sorted, unsigned NumThreads = 1) const;
   /// @}
 
   /// \name DataObject-Related Public Types and Functions
@@ -611,13 +898,14 @@ public:
   /// same address, the smaller one is returned first. If two DataObjects have
   /// the same address and the same size, their order is not specified.
   using data_object_range = boost::iterator_range<data_object_iterator>;
-  /// \brief Sub-range of data objects overlapping an address (\ref DataObject).
+  /// \brief Sub-range of data objects overlapping an address or address
+  /// range (\ref DataObject).
   ///
   /// DataObjects are returned in address order. If two DataObjects start at the
   /// same address, the smaller one is returned first. If two DataObjects have
   /// the same address and the same size, their order is not specified.
   using data_object_subrange = boost::iterator_range<
-      boost::indirect_iterator<DataIntMap::codomain_type::iterator>>;
+      boost::indirect_iterator<DataAddrIndex::iterator>>;
   /// \brief Constant iterator over data objects (\ref DataObject).
   ///
   /// DataObjects are returned in address order. If two DataObjects start at the
@@ -632,15 +920,15 @@ public:
   /// the same address and the same size, their order is not specified.
   using const_data_object_range =
       boost::iterator_range<const_data_object_iterator>;
-  /// \brief Constant sub-range of data objects overlapping an address
-  /// (\ref DataObject).
+  /// \brief Constant sub-range of data objects overlapping an address or
+  /// address range (\ref DataObject).
   ///
   /// DataObjects are returned in address order. If two DataObjects start at the
   /// same address, the smaller one is returned first. If two DataObjects have
   /// the same address and the same size, their order is not specified.
   using const_data_object_subrange =
-      boost::iterator_range<boost::indirect_iterator<
-          DataIntMap::codomain_type::const_iterator, const DataObject&>>;
+      boost::iterator_range<boost::indirect_iterator<DataAddrIndex::iterator,
+                                                     const DataObject&>>;
 
   /// \brief Return an iterator to the first DataObject.
   data_object_iterator data_begin() { return Data.begin(); }
@@ -675,21 +963,51 @@ public:
   void addData(std::initializer_list<DataObject*> Ds) {
     for (auto* D : Ds)
       if (Data.emplace(D).second)
-        DataAddrs.add(std::make_pair(DataIntMap::interval_type::right_open(
-                                         D->getAddress(), addressLimit(*D)),
-                                     DataIntMap::codomain_type{D}));
+        DataAddrs.insert(D);
+  }
+
+  /// \brief Add a range of data objects to the module.
+  ///
+  /// Like \ref addBlocks(InputIterator, InputIterator), this updates each
+  /// index once for the whole range.
+  ///
+  /// \param Begin  The start of the range of DataObject objects to add.
+  /// \param End    The end of the range of DataObject objects to add.
+  ///
+  /// \return void
+  template <typename InputIterator>
+  void addData(InputIterator Begin, InputIterator End) {
+    insertData(std::vector<DataObject*>(Begin, End));
   }
 
+  /// \brief Remove a data object from the module.
+  ///
+  /// The data object is not destroyed, and may be added to a module again.
+  /// Symbols referring to it keep its address but no longer have a referent.
+  ///
+  /// \param DO The DataObject object to remove.
+  ///
+  /// \return Whether the data object was in the module.
+  bool removeData(DataObject* DO);
+
+  /// \brief Remove a data object from the module and destroy it.
+  ///
+  /// If the data object is not in the module, nothing happens. Symbols
+  /// referring to it keep its address but no longer have a referent.
+  ///
+  /// \param DO The DataObject object to erase.
+  ///
+  /// \return void
+  void eraseData(DataObject* DO);
+
   /// \brief Find a DataObject containing an address.
   ///
   /// \param X The address to look up.
   ///
   /// \return The range of DataObjects containing the address.
   data_object_subrange findData(Addr X) {
-    auto it = DataAddrs.find(X);
-    if (it == DataAddrs.end())
-      return {};
-    return boost::make_iterator_range(it->second.begin(), it->second.end());
+    auto Found = DataAddrs.find(X);
+    return boost::make_iterator_range(Found.begin(), Found.end());
   }
 
   /// \brief Find a DataObject containing an address.
@@ -698,11 +1016,64 @@ public:
   ///
   /// \return The range of DataObjects containing the address.
   const_data_object_subrange findData(Addr X) const {
-    auto it = DataAddrs.find(X);
-    if (it == DataAddrs.end())
-      return {};
-    return boost::make_iterator_range(it->second.cbegin(), it->second.cend());
+    auto Found = DataAddrs.find(X);
+    return boost::make_iterator_range(Found.begin(), Found.end());
   }
+
+  /// \brief Find the DataObjects overlapping a range of addresses.
+  ///
+  /// The DataObjects are found by walking the address index as the range is
+  /// iterated, so only the overlapping DataObjects are visited. One of size
+  /// zero overlaps the range if its address lies strictly within it.
+  ///
+  /// \param Lower The start of the range.
+  /// \param Upper The end of the range, which is not included.
+  ///
+  /// \return The range of DataObjects overlapping [Lower, Upper).
+  data_object_subrange findData(Addr Lower, Addr Upper) {
+    auto Found = DataAddrs.find(Lower, Upper);
+    return boost::make_iterator_range(Found.begin(), Found.end());
+  }
+
+  /// \brief Find the DataObjects overlapping a range of addresses.
+  ///
+  /// The DataObjects are found by walking the address index as the range is
+  /// iterated, so only the overlapping DataObjects are visited. One of size
+  /// zero overlaps the range if its address lies strictly within it.
+  ///
+  /// \param Lower The start of the range.
+  /// \param Upper The end of the range, which is not included.
+  ///
+  /// \return The constant range of DataObjects overlapping [Lower, Upper).
+  const_data_object_subrange findData(Addr Lower, Addr Upper) const {
+    auto Found = DataAddrs.find(Lower, Upper);
+    return boost::make_iterator_range(Found.begin(), Found.end());
+  }
+
+  /// \brief Find the DataObjects containing each of a sorted sequence of
+  /// addresses.
+  ///
+  /// This walks the address index once alongside the addresses, instead of
+  /// searching it for each address.
+  ///
+  /// \param Sorted      The addresses to look up, in ascending order.
+  /// \param NumThreads  The number of threads to divide the addresses among.
+  ///
+  /// \return The range of DataObjects containing each address, in the same
+  /// order as \p Sorted.
+  std::vector<data_object_subrange> findData(const std::vector<Addr>& Sorted,
+                                             unsigned NumThreads = 1);
+
+  /// \brief Find the DataObjects containing each of a sorted sequence of
+  /// addresses.
+  ///
+  /// \param Sorted      The addresses to look up, in ascending order.
+  /// \param NumThreads  The number of threads to divide the addresses among.
+  ///
+  /// \return The constant range of DataObjects containing each address, in the
+  /// same order as \p Sorted.
+  std::vector<const_data_object_subrange>
+  findData(const std::vector<Addr>& Sorted, unsigned NumThreads = 1) const;
   /// @}
   // (end group of DataObject-related types and functions)
 
@@ -721,13 +1092,14 @@ public:
   /// same address, the smaller one is returned first. If two Sections have
   /// the same address and the same size, their order is not specified.
   using section_range = boost::iterator_range<section_iterator>;
-  /// \brief Sub-range of sections overlapping an address (\ref Section).
+  /// \brief Sub-range of sections overlapping an address or address range
+  /// (\ref Section).
   ///
   /// Sections are returned in address order. If two Sections start at the
   /// same address, the smaller one is returned first. If two Sections have
   /// the same address and the same size, their order is not specified.
   using section_subrange = boost::iterator_range<
-      boost::indirect_iterator<SectionIntMap::codomain_type::iterator>>;
+      boost::indirect_iterator<SectionAddrIndex::iterator>>;
   /// \brief Iterator over sections (\ref Section).
   ///
   /// Sections are returned in name order. If two Sections have the same name,
@@ -752,14 +1124,14 @@ public:
   /// same address, the smaller one is returned first. If two Sections have
   /// the same address and the same size, their order is not specified.
   using const_section_range = boost::iterator_range<const_section_iterator>;
-  /// \brief Constant sub-range of sections overlapping an address
-  /// (\ref Section).
+  /// \brief Constant sub-range of sections overlapping an address or
+  /// address range (\ref Section).
   ///
   /// Sections are returned in address order. If two Sections start at the
   /// same address, the smaller one is returned first. If two Sections have
   /// the same address and the same size, their order is not specified.
-  using const_section_subrange = boost::iterator_range<boost::indirect_iterator<
-      SectionIntMap::codomain_type::const_iterator, const Section&>>;
+  using const_section_subrange = boost::iterator_range<
+      boost::indirect_iterator<SectionAddrIndex::iterator, const Section&>>;
   /// \brief Constant iterator over sections (\ref Section).
   ///
   /// Sections are returned in name order. If two Sections have the same name,
@@ -824,22 +1196,49 @@ public:
   void addSection(std::initializer_list<Section*> Ss) {
     for (auto* S : Ss)
       if (Sections.emplace(S).second)
-        SectionAddrs.add(
-            std::make_pair(SectionIntMap::interval_type::right_open(
-                               S->getAddress(), addressLimit(*S)),
-                           SectionIntMap::codomain_type{S}));
+        SectionAddrs.insert(S);
+  }
+
+  /// \brief Add a range of section objects to the module.
+  ///
+  /// Like \ref addBlocks(InputIterator, InputIterator), this builds each
+  /// index once for the whole range.
+  ///
+  /// \param Begin  The start of the range of Section objects to add.
+  /// \param End    The end of the range of Section objects to add.
+  ///
+  /// \return void
+  template <typename InputIterator>
+  void addSection(InputIterator Begin, InputIterator End) {
+    insertSections(std::vector<Section*>(Begin, End));
   }
 
+  /// \brief Remove a section from the module.
+  ///
+  /// The section is not destroyed, and may be added to a module again.
+  ///
+  /// \param S The Section object to remove.
+  ///
+  /// \return Whether the section was in the module.
+  bool removeSection(Section* S);
+
+  /// \brief Remove a section from the module and destroy it.
+  ///
+  /// If the section is not in the module, nothing happens.
+  ///
+  /// \param S The Section object to erase.
+  ///
+  /// \return void
+  void eraseSection(Section* S);
+
   /// \brief Find a Section containing an address.
   ///
   /// \param X The address to look up.
   ///
   /// \return The range of Sections containing the address.
   section_subrange findSection(Addr X) {
-    auto it = SectionAddrs.find(X);
-    if (it == SectionAddrs.end())
-      return {};
-    return boost::make_iterator_range(it->second.begin(), it->second.end());
+    auto Found = SectionAddrs.find(X);
+    return boost::make_iterator_range(Found.begin(), Found.end());
   }
 
   /// \brief Find a Section containing an address.
@@ -848,10 +1247,54 @@ public:
   ///
   /// \return The range of Sections containing the address.
   const_section_subrange findSection(Addr X) const {
-    auto it = SectionAddrs.find(X);
-    if (it == SectionAddrs.end())
-      return {};
-    return boost::make_iterator_range(it->second.begin(), it->second.end());
+    auto Found = SectionAddrs.find(X);
+    return boost::make_iterator_range(Found.begin(), Found.end());
+  }
+
+  /// \brief Find the Sections overlapping a range of addresses.
+  ///
+  /// The Sections are found by walking the address index as the range is
+  /// iterated, so only the overlapping Sections are visited. One of size zero
+  /// overlaps the range if its address lies strictly within it.
+  ///
+  /// \param Lower The start of the range.
+  /// \param Upper The end of the range, which is not included.
+  ///
+  /// \return The range of Sections overlapping [Lower, Upper).
+  section_subrange findSections(Addr Lower, Addr Upper) {
+    auto Found = SectionAddrs.find(Lower, Upper);
+    return boost::make_iterator_range(Found.begin(), Found.end());
+  }
+
+  /// \brief Find the Sections overlapping a range of addresses.
+  ///
+  /// The Sections are found by walking the address index as the range is
+  /// iterated, so only the overlapping Sections are visited. One of size zero
+  /// overlaps the range if its address lies strictly within it.
+  ///
+  /// \param Lower The start of the range.
+  /// \param Upper The end of the range, which is not included.
+  ///
+  /// \return The constant range of Sections overlapping [Lower, Upper).
+  const_section_subrange findSections(Addr Lower, Addr Upper) const {
+    auto Found = SectionAddrs.find(Lower, Upper);
+    return boost::make_iterator_range(Found.begin(), Found.end());
+  }
+
+  /// \brief Build tables mapping each page of memory to the blocks, data
+  /// objects and sections covering it.
+  ///
+  /// This speeds up \ref findBlock(Addr), \ref findData(Addr) and
+  /// \ref findSection(Addr) until the next time a block, data object or
+  /// section is added, removed or moved. Loading a module builds the tables
+  /// too. Call this once a module stops changing, before looking up many
+  /// addresses.
+  ///
+  /// \return void
+  void buildPageTables() {
+    BlockAddrs.buildPageTable();
+    DataAddrs.buildPageTable();
+    SectionAddrs.buildPageTable();
   }
 
   /// \brief Find a Section by name.
@@ -915,7 +1358,9 @@ public:
   /// found. The end of the iterator range can be obtained by calling
   /// symbolic_expr_end().
   const_symbolic_expr_iterator findSymbolicExpression(Addr X) const {
-    return const_symbolic_expr_iterator(SymbolicOperands.find(X));
+    const auto& Index = boost::multi_index::get<2>(SymbolicOperands);
+    return const_symbolic_expr_iterator(
+        SymbolicOperands.project<0>(Index.find(X)));
   }
 
   /// \brief Find symbolic expressions (\ref SymbolicExpression) by a range of
@@ -967,10 +1412,60 @@ public:
   ///
   /// \return void
   void addSymbolicExpression(Addr X, const SymbolicExpression& SE) {
-    if (auto it = SymbolicOperands.find(X); it != SymbolicOperands.end())
-      SymbolicOperands.replace(it, {X, SE});
-    else
+    auto& Index = boost::multi_index::get<2>(SymbolicOperands);
+    if (auto it = Index.find(X); it != Index.end()) {
+      removeSymbolReferences(X, it->second);
+      Index.replace(it, {X, SE});
+    } else {
       SymbolicOperands.emplace(X, SE);
+    }
+    addSymbolReferences(X, SE);
+  }
+
+  /// \brief Remove the symbolic expression (\ref SymbolicExpression) at an
+  /// address from the module.
+  ///
+  /// \param X  The address of the symbolic expression.
+  ///
+  /// \return Whether there was a symbolic expression at the address.
+  bool removeSymbolicExpression(Addr X) {
+    auto& Index = boost::multi_index::get<2>(SymbolicOperands);
+    auto It = Index.find(X);
+    if (It == Index.end())
+      return false;
+    removeSymbolReferences(X, It->second);
+    Index.erase(It);
+    return true;
+  }
+
+  /// \brief Iterator over the addresses of symbolic expressions
+  /// (\ref SymbolicExpression) which refer to a Symbol.
+  using const_symbol_reference_iterator =
+      boost::transform_iterator<ExtractNth<1>,
+                                SymbolReferenceSet::const_iterator>;
+  /// \brief Range of the addresses of symbolic expressions
+  /// (\ref SymbolicExpression) which refer to a Symbol.
+  using const_symbol_reference_range =
+      boost::iterator_range<const_symbol_reference_iterator>;
+
+  /// \brief Find the symbolic expressions (\ref SymbolicExpression) which
+  /// refer to a symbol.
+  ///
+  /// \param S The symbol to look up.
+  ///
+  /// \return A possibly empty range of the addresses, in increasing order, of
+  /// every SymStackConst, SymAddrConst or SymAddrAddr naming \p S. Each
+  /// address appears once even if the expression names \p S twice.
+  ///
+  /// The lookup takes logarithmic time; it does not scan the symbolic
+  /// expressions. Use findSymbolicExpression() to get the expressions.
+  const_symbol_reference_range
+  getSymbolicExpressionAddrs(const Symbol& S) const {
+    return boost::make_iterator_range(
+        const_symbol_reference_iterator(
+            SymbolReferences.lower_bound({&S, Addr(0)})),
+        const_symbol_reference_iterator(SymbolReferences.upper_bound(
+            {&S, Addr(std::numeric_limits<uint64_t>::max())})));
   }
   /// @}
   // (end group of SymbolicExpression-related type aliases and methods)
@@ -994,10 +1489,42 @@ public:
   /// \return The deserialized Module object, or null on failure.
   static Module* fromProtobuf(Context& C, const MessageType& Message);
 
+  /// \brief Get the size of the serialized Module message.
+  ///
+  /// \return The number of bytes writeProtobuf() will write.
+  size_t protobufSize() const;
+
+  /// \brief Serialize directly to a stream.
+  ///
+  /// The image bytes and AuxData are written from their existing storage
+  /// instead of being copied into a Module message first.
+  ///
+  /// \param Out  The stream to write to.
+  ///
+  /// \return void
+  void writeProtobuf(google::protobuf::io::CodedOutputStream& Out) const;
+
+  /// \brief Serialize directly to a stream as a field of an enclosing
+  /// message.
+  ///
+  /// The image bytes and AuxData are written from their existing storage
+  /// instead of being copied into a Module message first.
+  ///
+  /// \param Out          The stream to write to.
+  /// \param FieldNumber  The number of the length-delimited field to write.
+  /// \param References   If not null, node references are written as ids in
+  ///                     this table rather than as UUIDs.
+  ///
+  /// \return void
+  void writeProtobufField(google::protobuf::io::CodedOutputStream& Out,
+                          int FieldNumber,
+                          UUIDTable* References = nullptr) const;
+
   static bool classof(const Node* N) { return N->getKind() == Kind::Module; }
 
   /// Needed by the serialization engine to work with SymbolicExpressionSet,
-  /// which is a type private to Module.
+  /// which is a type private to Module. The caller rebuilds the symbol
+  /// references afterwards.
   friend void addElement(SymbolicExpressionSet& Container,
                          SymbolicExpressionElement&& Element) {
     Container.insert(std::move(Element));
@@ -1005,6 +1532,69 @@ public:
   /// @endcond
 
 private:
+  // Serialize everything except the ImageByteMap and AuxData.
+  void fieldsToProtobuf(MessageType* Message) const;
+
+  // Deserialization happens in stages so that modules can be loaded in
+  // parallel. Each stage looks up only nodes created by earlier stages, which
+  // may belong to other modules, so every module must finish a stage before
+  // any module starts the next.
+  //
+  // Create the Module and every node it owns except Symbols.
+  static Module* nodesFromProtobuf(Context& C, const MessageType& Message);
+  // Create Symbols, which may refer to nodes, and the CFG. References saved
+  // as ids index into References.
+  void symbolsFromProtobuf(Context& C, const MessageType& Message,
+                           const UUIDTable* References);
+  // Create SymbolicExpressions, which may refer to Symbols.
+  void symbolicExpressionsFromProtobuf(Context& C, const MessageType& Message,
+                                       const UUIDTable* References);
+
+  // Add many nodes at once, updating each index once. Nodes already in the
+  // module are skipped.
+  void insertBlocks(std::vector<Block*> Bs);
+  void insertData(std::vector<DataObject*> Ds);
+  void insertProxyBlocks(std::vector<ProxyBlock*> Ps);
+  void insertSections(std::vector<Section*> Ss);
+  template <typename SetTy, typename IndexTy, typename NodeTy>
+  static void insertSorted(SetTy& Set, IndexTy& AddrIndex,
+                           std::vector<NodeTy*>& New);
+
+  // When a node leaves the module, replace the referent of each symbol
+  // referring to it with the node's address, if it has one.
+  void detachSymbols(const Node* N);
+  // Before a symbol is destroyed, remove the symbolic expressions naming it.
+  void removeSymbolicExpressions(const Symbol* S);
+
+  // Record or forget the symbols mentioned by the symbolic expression at an
+  // address.
+  void addSymbolReferences(Addr X, const SymbolicExpression& SE);
+  void removeSymbolReferences(Addr X, const SymbolicExpression& SE);
+
+  // Change the address or size of a node, moving it within the indexes
+  // which are keyed on them. Symbols referring to the node take their
+  // address from it, so they are taken out of the symbol indexes while it
+  // changes and then put back.
+  template <typename SetTy, typename IndexTy, typename NodeTy,
+            typename ModifierTy>
+  void modifyExtent(SetTy& Set, IndexTy& AddrIndex, NodeTy& N,
+                    ModifierTy Modify) {
+    auto& ByReferent = Symbols.get<by_referent>();
+    auto [First, Last] = ByReferent.equal_range(&N);
+    std::vector<Symbol*> Referring(First, Last);
+    ByReferent.erase(First, Last);
+
+    auto& Index = Set.template get<by_pointer>();
+    if (auto It = Index.find(&N); It != Index.end()) {
+      AddrIndex.erase(&N);
+      Index.modify(It, [&Modify](NodeTy*) { Modify(); });
+      AddrIndex.insert(&N);
+    } else {
+      Modify();
+    }
+    Symbols.insert(Referring.begin(), Referring.end());
+  }
+
   std::string BinaryPath{};
   Addr PreferredAddr;
   int64_t RebaseDelta{0};
@@ -1013,17 +1603,19 @@ private:
   std::string Name{};
   CFG Cfg;
   BlockSet Blocks;
-  BlockIntMap BlockAddrs;
+  BlockAddrIndex BlockAddrs;
   DataSet Data;
-  DataIntMap DataAddrs;
+  DataAddrIndex DataAddrs;
   ImageByteMap* ImageBytes;
   ProxyBlockSet ProxyBlocks;
   SectionSet Sections;
-  SectionIntMap SectionAddrs;
+  SectionAddrIndex SectionAddrs;
   SymbolSet Symbols;
   SymbolicExpressionSet SymbolicOperands;
+  SymbolReferenceSet SymbolReferences;
 
   friend class Context; // Allow Context to construct new Modules.
+  friend class IR;      // Allow IR to deserialize Modules in parallel.
 
   // Allow changing the module's name.
   friend void setModuleName(IR& Ir, Module& M, const std::string& X);
@@ -1034,6 +1626,14 @@ private:
   template <typename NodeTy>
   friend std::enable_if_t<Symbol::is_supported_type<NodeTy>()>
   setReferent(Module& M, Symbol& S, NodeTy* N);
+
+  // Allow these methods to move Blocks, DataObjects and Sections.
+  friend void setAddress(Module& M, Block& B, Addr A);
+  friend void setSize(Module& M, Block& B, uint64_t S);
+  friend void setAddress(Module& M, DataObject& D, Addr A);
+  friend void setSize(Module& M, DataObject& D, uint64_t S);
+  friend void setAddress(Module& M, Section& S, Addr A);
+  friend void setSize(Module& M, Section& S, uint64_t Size);
 };
 
 /// \relates Addr
@@ -1113,7 +1713,10 @@ Symbol* emplaceSymbol(Module& M, Context& C, Ts&&... Args) {
 /// \param N  The new name to assign.
 inline void renameSymbol(Module& M, Symbol& S, const std::string& N) {
   auto& Index = M.Symbols.get<Module::by_pointer>();
-  Index.modify(Index.find(&S), [&N, &S](Symbol*) { S.Name = N; });
+  const std::string* Old = S.Name;
+  const std::string* Name = &S.getContext().internString(N);
+  Index.modify(Index.find(&S), [Name, &S](Symbol*) { S.Name = Name; });
+  S.getContext().releaseString(*Old);
 }
 
 /// \relates Module
@@ -1160,6 +1763,88 @@ inline void setSymbolAddress(Module& M, Symbol& S, Addr A) {
   auto& Index = M.Symbols.get<Module::by_pointer>();
   Index.modify(Index.find(&S), [&A, &S](Symbol*) { S.Payload = A; });
 }
+
+/// \relates Module
+/// \relates Block
+/// \brief Set the address of a block and update the module's indexes.
+///
+/// The block is moved within the address indexes in logarithmic time, so
+/// future calls to findBlock will find it at the new address. Symbols
+/// referring to the block move with it. If the block is not in the module,
+/// only its address changes.
+///
+/// \param M  The module containing the block.
+/// \param B  The block to modify.
+/// \param A  The new address to assign.
+inline void setAddress(Module& M, Block& B, Addr A) {
+  M.modifyExtent(M.Blocks, M.BlockAddrs, B, [&A, &B] { B.Address = A; });
+}
+
+/// \relates Module
+/// \relates Block
+/// \brief Set the size of a block and update the module's indexes.
+///
+/// \param M  The module containing the block.
+/// \param B  The block to modify.
+/// \param S  The new size to assign.
+inline void setSize(Module& M, Block& B, uint64_t S) {
+  M.modifyExtent(M.Blocks, M.BlockAddrs, B, [&S, &B] { B.Size = S; });
+}
+
+/// \relates Module
+/// \relates DataObject
+/// \brief Set the address of a data object and update the module's indexes.
+///
+/// The data object is moved within the address indexes in logarithmic time, so
+/// future calls to findData will find it at the new address. Symbols referring
+/// to the data object move with it. If the data object is not in the module,
+/// only its address changes.
+///
+/// \param M  The module containing the data object.
+/// \param D  The data object to modify.
+/// \param A  The new address to assign.
+inline void setAddress(Module& M, DataObject& D, Addr A) {
+  M.modifyExtent(M.Data, M.DataAddrs, D, [&A, &D] { D.Address = A; });
+}
+
+/// \relates Module
+/// \relates DataObject
+/// \brief Set the size of a data object and update the module's indexes.
+///
+/// \param M  The module containing the data object.
+/// \param D  The data object to modify.
+/// \param S  The new size to assign.
+inline void setSize(Module& M, DataObject& D, uint64_t S) {
+  M.modifyExtent(M.Data, M.DataAddrs, D, [&S, &D] { D.Size = S; });
+}
+
+/// \relates Module
+/// \relates Section
+/// \brief Set the address of a section and update the module's indexes.
+///
+/// The section is moved within the address indexes in logarithmic time, so
+/// future calls to findSection will find it at the new address. If the section
+/// is not in the module, only its address changes.
+///
+/// \param M  The module containing the section.
+/// \param S  The section to modify.
+/// \param A  The new address to assign.
+inline void setAddress(Module& M, Section& S, Addr A) {
+  M.modifyExtent(M.Sections, M.SectionAddrs, S,
+                 [&A, &S] { S.Address = A; });
+}
+
+/// \relates Module
+/// \relates Section
+/// \brief Set the size of a section and update the module's indexes.
+///
+/// \param M  The module containing the section.
+/// \param S  The section to modify.
+/// \param Size  The new size to assign.
+inline void setSize(Module& M, Section& S, uint64_t Size) {
+  M.modifyExtent(M.Sections, M.SectionAddrs, S,
+                 [&Size, &S] { S.Size = Size; });
+}
 } // namespace gtirb
 
 #endif // GTIRB_MODULE_H
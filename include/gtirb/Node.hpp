@@ -18,6 +18,7 @@
 #include <gtirb/Casting.hpp>
 #include <gtirb/Context.hpp>
 #include <gtirb/Export.hpp>
+#include <atomic>
 #include <string>
 
 /// \file Node.hpp
@@ -85,8 +86,16 @@ public:
 
   /// \brief Get the Universally Unique ID (UUID) for \c this.
   ///
+  /// If the node was created with lazy UUIDs (see Context::setLazyUUIDs()),
+  /// this assigns its UUID on the first call. Threads making that call at
+  /// the same time all get the same UUID.
+  ///
   /// \return The UUID.
-  const UUID& getUUID() const { return Uuid; }
+  const UUID& getUUID() const {
+    if (!HasUuid.load(std::memory_order_acquire))
+      Ctx->assignLazyUUID(this);
+    return Uuid;
+  }
 
   /// \cond INTERNAL
   Kind getKind() const { return K; }
@@ -102,16 +111,34 @@ public:
 protected:
   /// \cond INTERNAL
   Node(Context& C, Kind Knd);
+
+  /// \brief Get the Context in which this node is held.
+  Context& getContext() const { return *Ctx; }
   /// \endcond
 
 private:
   Kind K;
-  UUID Uuid;
+  // Nil until assigned, if the node was created with lazy UUIDs.
+  mutable UUID Uuid;
   // The Context object can never be null as it can only be passed to the Node
   // constructor by reference. However, we don't want to store a reference to
   // the Context object because we want to keep the Node class copyable and
   // Context needs to own a move-only allocator.
   Context* Ctx;
+  // The Context allocator shard holding this node.
+  uint8_t AllocatorShard{0};
+  // An atomic flag which is copied along with the node.
+  struct CopyableFlag : std::atomic<bool> {
+    CopyableFlag(bool B) : std::atomic<bool>(B) {}
+    CopyableFlag(const CopyableFlag& F) : std::atomic<bool>(F.load()) {}
+    CopyableFlag& operator=(const CopyableFlag& F) {
+      store(F.load());
+      return *this;
+    }
+  };
+  // Set once Uuid is assigned, so a lazy UUID is published to other threads
+  // only after it is complete.
+  mutable CopyableFlag HasUuid;
 
   // Assign a new UUID to this node. This is only needed when deserializing
   // objects, as there are no constructors allowing the user to set the UUID on
@@ -0,0 +1,188 @@
+//===- NodeRegistry.hpp -----------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2018 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GTIRB_NODE_REGISTRY_H
+#define GTIRB_NODE_REGISTRY_H
+
+#include <boost/uuid/uuid.hpp>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/// \file NodeRegistry.hpp
+/// \brief Class gtirb::NodeRegistry.
+
+namespace gtirb {
+class Node;
+
+/// \class NodeRegistry
+///
+/// \brief A hash table mapping the UUID of each Node in a \ref Context to the
+/// Node.
+///
+/// The table uses open addressing with linear probing, so entries are stored
+/// inline in a single array and a lookup usually touches one cache line.
+/// Entries are removed by shifting later entries of the same probe sequence
+/// back, so no tombstones accumulate.
+class NodeRegistry {
+public:
+  /// \brief Add a node, replacing any node already registered with the same
+  /// UUID.
+  ///
+  /// \param ID  The UUID of the node.
+  /// \param N   The node. Must not be null.
+  ///
+  /// \return void
+  void insert(const boost::uuids::uuid& ID, Node* N) {
+    assert(N && "cannot register a null node");
+    if ((Count + 1) * 4 > Slots.size() * 3)
+      grow();
+    size_t I = probe(ID);
+    if (!Slots[I].N) {
+      Slots[I].ID = ID;
+      ++Count;
+    }
+    Slots[I].N = N;
+  }
+
+  /// \brief Add a node unless a node is already registered with the same
+  /// UUID.
+  ///
+  /// \param ID  The UUID of the node.
+  /// \param N   The node. Must not be null.
+  ///
+  /// \return Whether the node was added.
+  bool insertNew(const boost::uuids::uuid& ID, Node* N) {
+    assert(N && "cannot register a null node");
+    if ((Count + 1) * 4 > Slots.size() * 3)
+      grow();
+    size_t I = probe(ID);
+    if (Slots[I].N)
+      return false;
+    Slots[I].ID = ID;
+    Slots[I].N = N;
+    ++Count;
+    return true;
+  }
+
+  /// \brief Remove the node registered with a UUID.
+  ///
+  /// \param ID  The UUID of the node.
+  ///
+  /// \return Whether a node was registered with the UUID.
+  bool erase(const boost::uuids::uuid& ID) {
+    if (Slots.empty())
+      return false;
+    size_t I = probe(ID);
+    if (!Slots[I].N)
+      return false;
+
+    // Move later entries back into the hole unless that would place them
+    // before their home slot.
+    size_t Mask = Slots.size() - 1;
+    for (size_t J = (I + 1) & Mask; Slots[J].N; J = (J + 1) & Mask) {
+      size_t Home = home(Slots[J].ID);
+      if (((J - Home) & Mask) >= ((J - I) & Mask)) {
+        Slots[I] = Slots[J];
+        I = J;
+      }
+    }
+    Slots[I].N = nullptr;
+    --Count;
+    return true;
+  }
+
+  /// \brief Find the node registered with a UUID.
+  ///
+  /// \param ID  The UUID to look up.
+  ///
+  /// \return The node, or null if no node is registered with the UUID.
+  Node* find(const boost::uuids::uuid& ID) const {
+    return Slots.empty() ? nullptr : Slots[probe(ID)].N;
+  }
+
+  /// \brief Remove every node, keeping the table's memory for reuse.
+  ///
+  /// \return void
+  void clear() {
+    for (auto& S : Slots)
+      S.N = nullptr;
+    Count = 0;
+  }
+
+  /// \brief Get the number of registered nodes.
+  size_t size() const { return Count; }
+
+  /// \brief Get the number of slots in the table.
+  size_t capacity() const { return Slots.size(); }
+
+  /// \brief Get the number of bytes used by the table.
+  size_t getMemoryUsage() const { return Slots.capacity() * sizeof(Slot); }
+
+  /// \brief Hash a UUID.
+  ///
+  /// UUIDs are usually random, but all of their bits are mixed anyway so
+  /// that sequentially assigned UUIDs spread out too. The table is indexed by
+  /// the low bits of the hash, leaving the high bits for sharding.
+  ///
+  /// \param ID  The UUID to hash.
+  ///
+  /// \return The hash of the UUID.
+  static uint64_t hash(const boost::uuids::uuid& ID) {
+    uint64_t Lo, Hi;
+    std::memcpy(&Lo, ID.data, sizeof(Lo));
+    std::memcpy(&Hi, ID.data + sizeof(Lo), sizeof(Hi));
+    uint64_t H = Lo ^ Hi;
+    H = (H ^ (H >> 33)) * 0xff51afd7ed558ccdULL;
+    H = (H ^ (H >> 33)) * 0xc4ceb9fe1a85ec53ULL;
+    return H ^ (H >> 33);
+  }
+
+private:
+  struct Slot {
+    boost::uuids::uuid ID;
+    Node* N; // Null if the slot is empty.
+  };
+
+  size_t home(const boost::uuids::uuid& ID) const {
+    return static_cast<size_t>(hash(ID)) & (Slots.size() - 1);
+  }
+
+  // Find the slot holding ID, or the empty slot where it would be inserted.
+  size_t probe(const boost::uuids::uuid& ID) const {
+    size_t Mask = Slots.size() - 1;
+    size_t I = home(ID);
+    while (Slots[I].N && Slots[I].ID != ID)
+      I = (I + 1) & Mask;
+    return I;
+  }
+
+  void grow() {
+    std::vector<Slot> Old;
+    Old.swap(Slots);
+    Slots.assign(Old.empty() ? 16 : Old.size() * 2,
+                 Slot{boost::uuids::uuid(), nullptr});
+    for (const auto& S : Old)
+      if (S.N)
+        Slots[probe(S.ID)] = S;
+  }
+
+  std::vector<Slot> Slots;
+  size_t Count{0};
+};
+} // namespace gtirb
+
+#endif // GTIRB_NODE_REGISTRY_H
@@ -109,6 +109,10 @@ private:
   uint64_t Size{0};
 
   friend class Context;
+
+  // Allow these methods to update Sections.
+  friend void setAddress(Module& M, Section& S, Addr A);
+  friend void setSize(Module& M, Section& S, uint64_t Size);
 };
 } // namespace gtirb
 
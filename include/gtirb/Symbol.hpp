@@ -30,6 +30,8 @@
 /// \brief Class gtirb::Symbol.
 
 namespace gtirb {
+class UUIDTable;
+
 /// \class Symbol
 ///
 /// \brief Represents a Symbol, which maps a name to an object in the IR.
@@ -227,6 +229,10 @@ public:
   /// \return The newly created object.
   static Symbol* Create(Context& C) { return C.Create<Symbol>(C); }
 
+  /// \brief Cleans up resources no longer needed by the Symbol object,
+  /// releasing its interned name.
+  ~Symbol() noexcept;
+
   /// \brief Create a Symbol object.
   ///
   /// \param C    The Context in which this object will be held.
@@ -303,8 +309,11 @@ public:
 
   /// \brief Get the name.
   ///
+  /// Names are interned in the Context (see Context::internString()), so
+  /// symbols with equal names return the same string object.
+  ///
   /// \return The name.
-  const std::string& getName() const { return Name; }
+  const std::string& getName() const { return *Name; }
 
   /// \brief Get the referent to which this symbol refers.
   ///
@@ -362,30 +371,42 @@ public:
   ///
   /// \param C   The Context in which the deserialized Symbol will be held.
   /// \param Message  The protobuf message from which to deserialize.
+  /// \param References  If not null, the table which a referent saved as an
+  ///                    id indexes into.
   ///
   /// \return The deserialized Symbol object, or null on failure.
-  static Symbol* fromProtobuf(Context& C, const MessageType& Message);
+  static Symbol* fromProtobuf(Context& C, const MessageType& Message,
+                              const UUIDTable* References = nullptr);
 
   static bool classof(const Node* N) { return N->getKind() == Kind::Symbol; }
   /// @endcond
 
 private:
-  Symbol(Context& C) : Node(C, Kind::Symbol) {}
+  Symbol(Context& C)
+      : Node(C, Kind::Symbol), Name(&C.internString(std::string())) {}
   Symbol(Context& C, const std::string& N, StorageKind SK = StorageKind::Extern)
-      : Node(C, Kind::Symbol), Payload(), Name(N), Storage(SK) {}
+      : Node(C, Kind::Symbol), Payload(), Name(&C.internString(N)),
+        Storage(SK) {}
   Symbol(Context& C, Addr X, const std::string& N,
          StorageKind SK = StorageKind::Extern)
-      : Node(C, Kind::Symbol), Payload(X), Name(N), Storage(SK) {}
+      : Node(C, Kind::Symbol), Payload(X), Name(&C.internString(N)),
+        Storage(SK) {}
   template <typename NodeTy>
   Symbol(Context& C, NodeTy* R, const std::string& N,
          StorageKind SK = StorageKind::Extern)
-      : Node(C, Kind::Symbol), Payload(R), Name(N), Storage(SK) {}
+      : Node(C, Kind::Symbol), Payload(R), Name(&C.internString(N)),
+        Storage(SK) {}
+  // Each symbol holds its interned name once, so symbols are not copied.
+  Symbol(const Symbol&) = delete;
+  Symbol& operator=(const Symbol&) = delete;
 
   std::variant<std::monostate, Addr, Node*> Payload;
-  std::string Name;
+  // Interned in the Context.
+  const std::string* Name;
   Symbol::StorageKind Storage{StorageKind::Extern};
 
   friend class Context; // Allow Context to construct Symbols.
+  friend class Module;  // Allow Module to detach Symbols from erased nodes.
 
   // Allow these methods to update Symbol contents.
   friend void renameSymbol(Module& M, Symbol& S, const std::string& N);
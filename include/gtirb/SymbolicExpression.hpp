@@ -33,6 +33,7 @@ class SymbolicExpression;
 }
 namespace gtirb {
 class Context;
+class UUIDTable;
 
 /// \defgroup SYMBOLIC_EXPRESSION_GROUP Symbolic Expressions and Operands
 /// \brief Represent data values or instruction operands which
@@ -89,10 +90,13 @@ using SymbolicExpression =
 ///                      SymbolicExpression will be held.
 /// \param      Message  The protobuf message from which to deserialize.
 /// \param[out] Result   The SymbolicExpression to initialize.
+/// \param      References  If not null, the table which symbol references
+///                         saved as ids index into.
 ///
 /// \return void
 GTIRB_EXPORT_API void fromProtobuf(Context& C, SymbolicExpression& Result,
-                                   const proto::SymbolicExpression& Message);
+                                   const proto::SymbolicExpression& Message,
+                                   const UUIDTable* References = nullptr);
 
 /// \brief Serialize a SymbolicExpression into a protobuf message.
 ///
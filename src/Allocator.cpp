@@ -0,0 +1,56 @@
+//===- Allocator.cpp --------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2018 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include "Allocator.hpp"
+#include <new>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+void* allocateHugePageSlab(size_t Size) {
+#ifdef _WIN32
+  return std::malloc(Size);
+#else
+  // Map an extra huge page, so the slab can start on a huge page boundary,
+  // then unmap whatever is left over on either side.
+  size_t MapSize = Size + HugePageSize;
+  void* Map = mmap(nullptr, MapSize, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (Map == MAP_FAILED)
+    throw std::bad_alloc();
+
+  char* Begin = static_cast<char*>(Map);
+  char* Slab = reinterpret_cast<char*>(alignAddr(Begin, HugePageSize));
+  if (Slab != Begin)
+    munmap(Begin, Slab - Begin);
+  if (size_t Tail = Begin + MapSize - (Slab + Size))
+    munmap(Slab + Size, Tail);
+
+#ifdef MADV_HUGEPAGE
+  // Only advice: without transparent huge pages, the slab still works.
+  madvise(Slab, Size, MADV_HUGEPAGE);
+#endif
+  return Slab;
+#endif
+}
+
+void deallocateHugePageSlab(void* Slab, size_t Size) {
+#ifdef _WIN32
+  (void)Size;
+  std::free(Slab);
+#else
+  munmap(Slab, Size);
+#endif
+}
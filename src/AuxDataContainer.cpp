@@ -52,3 +52,42 @@ void AuxDataContainer::fromProtobuf(AuxDataContainer* in, Context& C,
                                     const MessageType& Message) {
   containerFromProtobuf(C, in->AuxDatas, Message.aux_data());
 }
+
+// Field numbers from AuxDataContainer.proto. Map entries are messages with the
+// key in field 1 and the value in field 2.
+static const int AuxDataField = 1;
+static const int KeyField = 1;
+static const int ValueField = 2;
+
+// Called from outside the class so that lookup finds the AuxData overload
+// rather than AuxDataContainer::toProtobuf.
+static proto::AuxData auxDataToProtobuf(const AuxData& Value) {
+  return toProtobuf(Value);
+}
+
+static size_t entrySize(const std::string& Key, size_t ValueSize) {
+  return lengthDelimitedFieldSize(KeyField, Key.size()) +
+         lengthDelimitedFieldSize(ValueField, ValueSize);
+}
+
+size_t AuxDataContainer::protobufSize() const {
+  size_t Size = 0;
+  for (const auto& [Key, Value] : this->AuxDatas) {
+    size_t ValueSize = auxDataToProtobuf(Value).ByteSizeLong();
+    Size += lengthDelimitedFieldSize(AuxDataField, entrySize(Key, ValueSize));
+  }
+  return Size;
+}
+
+void AuxDataContainer::writeProtobuf(
+    google::protobuf::io::CodedOutputStream& Out) const {
+  for (const auto& [Key, Value] : this->AuxDatas) {
+    auto Message = auxDataToProtobuf(Value);
+    size_t ValueSize = Message.ByteSizeLong();
+    writeLengthDelimitedField(Out, AuxDataField, entrySize(Key, ValueSize));
+    writeLengthDelimitedField(Out, KeyField, Key.size());
+    Out.WriteString(Key);
+    writeLengthDelimitedField(Out, ValueField, ValueSize);
+    Message.SerializeWithCachedSizes(&Out);
+  }
+}
@@ -64,34 +64,87 @@ ByteMap::const_range ByteMap::data(Addr A, size_t Bytes) const {
     return ByteMap::const_range{};
   }
 
-  auto Begin = Reg->Data.begin() + (A - Reg->Address);
+  auto Begin = Reg->begin() + (A - Reg->Address);
   return {Begin, Begin + Bytes};
 }
 
-namespace gtirb {
-proto::Region toProtobuf(const ByteMap::Region& R) {
-  proto::Region Message;
-  Message.set_address(static_cast<uint64_t>(R.Address));
-  std::transform(R.Data.begin(), R.Data.end(),
-                 std::back_inserter(*Message.mutable_data()),
-                 [](auto x) { return char(x); });
-  return Message;
+bool ByteMap::addMappedRegion(Addr A, const std::byte* Bytes, size_t Size) {
+  Addr Limit = A + Size;
+  auto Pos = std::lower_bound(
+      this->Regions.begin(), this->Regions.end(), A,
+      [](const auto& R, Addr X) { return R.Address < X; });
+  if (Pos != this->Regions.end() && Limit > Pos->Address)
+    return false;
+  if (Pos != this->Regions.begin() && addressLimit(*std::prev(Pos)) > A)
+    return false;
+
+  Region R = {A, std::vector<std::byte>()};
+  R.Mapped = Bytes;
+  R.MappedSize = Size;
+  this->Regions.insert(Pos, std::move(R));
+  return true;
 }
 
+namespace gtirb {
 void fromProtobuf(Context&, ByteMap::Region& Val,
                   const proto::Region& Message) {
   Val.Address = Addr(Message.address());
   const auto& Data = Message.data();
-  Val.Data.reserve(Data.size());
-  std::transform(Data.begin(), Data.end(), std::back_inserter(Val.Data),
-                 [](auto x) { return std::byte(x); });
+  const auto* Begin = reinterpret_cast<const std::byte*>(Data.data());
+  Val.Data.assign(Begin, Begin + Data.size());
 }
 } // namespace gtirb
 
 void ByteMap::toProtobuf(MessageType* Message) const {
-  containerToProtobuf(this->Regions, Message->mutable_regions());
+  // Build regions in place, so they share the message's arena (if any).
+  auto* MessageRegions = Message->mutable_regions();
+  initContainer(MessageRegions, this->Regions.size());
+  for (const auto& R : this->Regions) {
+    auto* M = MessageRegions->Add();
+    M->set_address(static_cast<uint64_t>(R.Address));
+    M->set_data(reinterpret_cast<const char*>(R.begin()), R.getSize());
+  }
 }
 
 void ByteMap::fromProtobuf(Context& C, const MessageType& Message) {
   containerFromProtobuf(C, this->Regions, Message.regions());
 }
+
+// Field numbers from ByteMap.proto.
+static const int RegionsField = 1;
+static const int RegionAddressField = 1;
+static const int RegionDataField = 2;
+
+// The size of a serialized Region. Default values are omitted, as they are by
+// the generated code.
+static size_t regionSize(const ByteMap::Region& R) {
+  using google::protobuf::io::CodedOutputStream;
+  size_t Size = 0;
+  if (uint64_t A = static_cast<uint64_t>(R.Address))
+    Size += 1 + CodedOutputStream::VarintSize64(A);
+  if (R.getSize() > 0)
+    Size += lengthDelimitedFieldSize(RegionDataField, R.getSize());
+  return Size;
+}
+
+size_t ByteMap::protobufSize() const {
+  size_t Size = 0;
+  for (const auto& R : this->Regions)
+    Size += lengthDelimitedFieldSize(RegionsField, regionSize(R));
+  return Size;
+}
+
+void ByteMap::writeProtobuf(
+    google::protobuf::io::CodedOutputStream& Out) const {
+  for (const auto& R : this->Regions) {
+    writeLengthDelimitedField(Out, RegionsField, regionSize(R));
+    if (uint64_t A = static_cast<uint64_t>(R.Address)) {
+      Out.WriteTag(RegionAddressField << 3);
+      Out.WriteVarint64(A);
+    }
+    if (R.getSize() > 0) {
+      writeLengthDelimitedField(Out, RegionDataField, R.getSize());
+      writeRawBytes(Out, R.begin(), R.getSize());
+    }
+  }
+}
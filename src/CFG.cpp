@@ -38,6 +38,36 @@ std::optional<CFG::vertex_descriptor> getVertex(const CfgNode* N,
   return std::nullopt;
 }
 
+bool removeVertex(const CfgNode* N, CFG& Cfg) {
+  auto& IdTable = Cfg[boost::graph_bundle];
+  auto it = IdTable.find(N);
+  if (it == IdTable.end())
+    return false;
+
+  auto Vertex = it->second;
+  IdTable.erase(it);
+  clear_vertex(Vertex, Cfg);
+
+  // Removing any vertex but the last renumbers every later vertex and every
+  // edge. Instead, move the last vertex and its edges into the hole and
+  // remove the last vertex, which only touches the edges of the two.
+  auto Last = num_vertices(Cfg) - 1;
+  if (Vertex != Last) {
+    for (auto [I, E] = out_edges(Last, Cfg); I != E; ++I) {
+      auto Target = target(*I, Cfg);
+      add_edge(Vertex, Target == Last ? Vertex : Target, Cfg[*I], Cfg);
+    }
+    for (auto [I, E] = in_edges(Last, Cfg); I != E; ++I)
+      if (auto Source = source(*I, Cfg); Source != Last)
+        add_edge(Source, Vertex, Cfg[*I], Cfg);
+    clear_vertex(Last, Cfg);
+    Cfg[Vertex] = Cfg[Last];
+    IdTable[Cfg[Vertex]] = Vertex;
+  }
+  remove_vertex(Last, Cfg);
+  return true;
+}
+
 std::optional<CFG::edge_descriptor> addEdge(const CfgNode* From,
                                             const CfgNode* To, CFG& Cfg) {
   const auto& IdTable = Cfg[boost::graph_bundle];
@@ -80,13 +110,18 @@ boost::iterator_range<block_iterator> blocks(CFG& Cfg) {
 
 proto::CFG toProtobuf(const CFG& Cfg) {
   proto::CFG Message;
-  auto MessageVertices = Message.mutable_vertices();
+  toProtobuf(Cfg, &Message);
+  return Message;
+}
+
+void toProtobuf(const CFG& Cfg, proto::CFG* Message) {
+  auto MessageVertices = Message->mutable_vertices();
   for (const Node& N : nodes(Cfg)) {
     auto* M = MessageVertices->Add();
     nodeUUIDToBytes(&N, *M);
   }
 
-  auto MessageEdges = Message.mutable_edges();
+  auto MessageEdges = Message->mutable_edges();
   for (const auto& E : boost::make_iterator_range(edges(Cfg))) {
     auto M = MessageEdges->Add();
     nodeUUIDToBytes(Cfg[source(E, Cfg)], *M->mutable_source_uuid());
@@ -99,20 +134,30 @@ proto::CFG toProtobuf(const CFG& Cfg) {
       L->set_type(static_cast<proto::EdgeType>(std::get<EdgeType>(*Label)));
     }
   }
-  return Message;
 }
 
-void fromProtobuf(Context& C, CFG& Result, const proto::CFG& Message) {
+// Find an edge endpoint, which may be stored as a UUID or as an id.
+static CfgNode* cfgNodeFromProtobuf(Context& C, const UUIDTable* References,
+                                    const std::string& Bytes, uint64_t Id) {
+  Node* N = Id != 0 ? nodeFromId(References, Id)
+                    : Node::getByUUID(C, uuidFromBytes(Bytes));
+  return dyn_cast_or_null<CfgNode>(N);
+}
+
+void fromProtobuf(Context& C, CFG& Result, const proto::CFG& Message,
+                  const UUIDTable* References) {
   for (const auto& M : Message.vertices()) {
     CfgNode* N =
         dyn_cast_or_null<CfgNode>(Node::getByUUID(C, uuidFromBytes(M)));
     addVertex(N, Result);
   }
+  for (uint64_t Id : Message.vertex_ids())
+    addVertex(dyn_cast_or_null<CfgNode>(nodeFromId(References, Id)), Result);
   for (const auto& M : Message.edges()) {
-    auto* Source = dyn_cast_or_null<CfgNode>(
-        Node::getByUUID(C, uuidFromBytes(M.source_uuid())));
-    auto* Target = dyn_cast_or_null<CfgNode>(
-        Node::getByUUID(C, uuidFromBytes(M.target_uuid())));
+    auto* Source = cfgNodeFromProtobuf(C, References, M.source_uuid(),
+                                       M.source_id());
+    auto* Target = cfgNodeFromProtobuf(C, References, M.target_uuid(),
+                                       M.target_id());
     if (Source && Target) {
       if (auto E = addEdge(Source, Target, Result); E && M.has_label()) {
         auto& L = M.label();
@@ -13,6 +13,7 @@
 //
 //===----------------------------------------------------------------------===//
 #include "Context.hpp"
+#include "MappedFile.hpp"
 #include <gtirb/Block.hpp>
 #include <gtirb/DataObject.hpp>
 #include <gtirb/IR.hpp>
@@ -22,51 +23,360 @@
 #include <gtirb/ProxyBlock.hpp>
 #include <gtirb/Section.hpp>
 #include <gtirb/Symbol.hpp>
+#include <cassert>
 
 using namespace gtirb;
 
 // By moving these declarations here, we avoid instantiating the default
 // ctor/dtor in other compilation units which include Context.hpp, where some
 // of the Node types may be incomplete.
-Context::Context() = default;
-Context::~Context() = default;
+Context::Context() { useRandomUUIDs(); }
+Context::~Context() {
+  // The registry is destroyed along with the nodes.
+  TearingDown = true;
+}
+
+size_t Context::threadShardIndex() const {
+  // Threads are spread across shards in the order they first create a node.
+  static std::atomic<size_t> NextThread{0};
+  thread_local size_t Index = NextThread++ % NumShards;
+  return Index;
+}
 
-void Context::unregisterNode(const Node* N) { UuidMap.erase(N->getUUID()); }
+void Context::seedUUIDs(std::vector<uint32_t> Seed) {
+  // Give each shard a distinct seed, derived from Seed and the shard index.
+  Seed.push_back(0);
+  for (auto& Shard : Allocators) {
+    std::seed_seq ShardSeed(Seed.begin(), Seed.end());
+    std::lock_guard<std::mutex> Lock(Shard.Mutex);
+    Shard.UuidRng.seed(ShardSeed);
+    ++Seed.back();
+  }
+  SequentialUUIDs = false;
+}
+
+void Context::useRandomUUIDs() {
+  std::random_device Entropy;
+  seedUUIDs({Entropy(), Entropy(), Entropy(), Entropy(), Entropy(),
+             Entropy(), Entropy(), Entropy()});
+}
+
+void Context::useRandomUUIDs(uint64_t Seed) {
+  seedUUIDs({static_cast<uint32_t>(Seed), static_cast<uint32_t>(Seed >> 32)});
+}
+
+void Context::useSequentialUUIDs(uint64_t Prefix) {
+  SequencePrefix = Prefix;
+  SequentialUUIDs = true;
+}
+
+// Store V in big-endian order, so sequential UUIDs also sort in order.
+static void storeUUIDWord(uint8_t* Dest, uint64_t V) {
+  for (int I = 7; I >= 0; --I, V >>= 8)
+    Dest[I] = static_cast<uint8_t>(V);
+}
+
+UUID Context::assignUUID(Node* N) {
+  UUID ID;
+  // A generated UUID may already be taken, by a node loaded from a file or
+  // created before the generator was reseeded, so draw until one is free.
+  do {
+    if (SequentialUUIDs) {
+      storeUUIDWord(ID.data, SequencePrefix);
+      storeUUIDWord(ID.data + 8, ++SequenceCounter);
+    } else {
+      AllocatorShard& Shard = threadShard();
+      std::lock_guard<std::mutex> Lock(Shard.Mutex);
+      // Mark the UUID as version 4 (random), variant 1, as RFC 4122 requires.
+      storeUUIDWord(ID.data, Shard.UuidRng());
+      storeUUIDWord(ID.data + 8, Shard.UuidRng());
+      ID.data[6] = static_cast<uint8_t>((ID.data[6] & 0x0F) | 0x40);
+      ID.data[8] = static_cast<uint8_t>((ID.data[8] & 0x3F) | 0x80);
+    }
+  } while (!registerNewUUID(ID, N));
+  return ID;
+}
+
+void Context::assignLazyUUID(const Node* N) {
+  std::lock_guard<std::mutex> Lock(LazyUUIDMutexes[N->AllocatorShard]);
+  if (N->HasUuid.load(std::memory_order_relaxed))
+    return;
+  N->Uuid = assignUUID(const_cast<Node*>(N));
+  N->HasUuid.store(true, std::memory_order_release);
+}
+
+void Context::unregisterNode(const Node* N) {
+  // Nodes without a UUID were never registered.
+  if (TearingDown || N->Uuid.is_nil())
+    return;
+  RegistryShard& Shard = registryShard(N->Uuid);
+  std::lock_guard<std::mutex> Lock(Shard.Mutex);
+  Shard.Nodes.erase(N->Uuid);
+}
 
 const Node* Context::findNode(const UUID& ID) const {
-  auto Iter = UuidMap.find(ID);
-  return Iter != UuidMap.end() ? Iter->second : nullptr;
+  const RegistryShard& Shard = registryShard(ID);
+  std::lock_guard<std::mutex> Lock(Shard.Mutex);
+  return Shard.Nodes.find(ID);
 }
 
 Node* Context::findNode(const UUID& ID) {
-  auto Iter = UuidMap.find(ID);
-  return Iter != UuidMap.end() ? Iter->second : nullptr;
+  RegistryShard& Shard = registryShard(ID);
+  std::lock_guard<std::mutex> Lock(Shard.Mutex);
+  return Shard.Nodes.find(ID);
+}
+
+void Context::reset(size_t MaxSlabs) {
+  // Destroy nodes in the same order as the Context's destructor would. The
+  // registry is cleared afterwards.
+  TearingDown = true;
+  for (auto& Shard : Allocators) {
+    std::lock_guard<std::mutex> Lock(Shard.Mutex);
+    Shard.SymbolAllocator.Reset(MaxSlabs);
+    Shard.SectionAllocator.Reset(MaxSlabs);
+    Shard.ProxyBlockAllocator.Reset(MaxSlabs);
+    Shard.ModuleAllocator.Reset(MaxSlabs);
+    Shard.IrAllocator.Reset(MaxSlabs);
+    Shard.ImageByteMapAllocator.Reset(MaxSlabs);
+    Shard.DataObjectAllocator.Reset(MaxSlabs);
+    Shard.BlockAllocator.Reset(MaxSlabs);
+    Shard.NodeAllocator.Reset(MaxSlabs);
+  }
+
+  for (auto& Shard : Registry) {
+    std::lock_guard<std::mutex> Lock(Shard.Mutex);
+    Shard.Nodes.clear();
+  }
+  TearingDown = false;
+
+  if (MaxSlabs == 0)
+    IndexMemory.release();
+  for (auto& Shard : InternedStrings) {
+    std::lock_guard<std::mutex> Lock(Shard.Mutex);
+    Shard.Strings.clear();
+  }
+
+  std::lock_guard<std::mutex> Lock(Mutex);
+  MappedFiles.clear();
+  SequenceCounter = 0;
+}
+
+static size_t stringShardIndex(const std::string& S, unsigned ShardBits) {
+  return static_cast<uint64_t>(std::hash<std::string>()(S)) >>
+         (64 - ShardBits);
+}
+
+const std::string& Context::internString(const std::string& S) {
+  StringShard& Shard = InternedStrings[stringShardIndex(S, ShardBits)];
+  std::lock_guard<std::mutex> Lock(Shard.Mutex);
+  auto It = Shard.Strings.try_emplace(S, 0).first;
+  ++It->second;
+  return It->first;
+}
+
+void Context::releaseString(const std::string& S) {
+  // The strings are all freed together when the Context is torn down.
+  if (TearingDown)
+    return;
+  StringShard& Shard = InternedStrings[stringShardIndex(S, ShardBits)];
+  std::lock_guard<std::mutex> Lock(Shard.Mutex);
+  auto It = Shard.Strings.find(S);
+  assert(It != Shard.Strings.end() && &It->first == &S &&
+         "string was not interned");
+  if (--It->second == 0)
+    Shard.Strings.erase(It);
+}
+
+const std::string* Context::findInternedString(const std::string& S) const {
+  const StringShard& Shard = InternedStrings[stringShardIndex(S, ShardBits)];
+  std::lock_guard<std::mutex> Lock(Shard.Mutex);
+  auto It = Shard.Strings.find(S);
+  return It == Shard.Strings.end() ? nullptr : &It->first;
+}
+
+bool Context::setHugePages(bool Enable) {
+  // Hold every shard, so the policy changes for all allocators or none.
+  std::vector<std::unique_lock<std::mutex>> Locks;
+  for (auto& Shard : Allocators)
+    Locks.emplace_back(Shard.Mutex);
+  for (const auto& Shard : Allocators) {
+    for (const BumpPtrAllocator* A :
+         {&Shard.NodeAllocator.getAllocator(),
+          &Shard.BlockAllocator.getAllocator(),
+          &Shard.DataObjectAllocator.getAllocator(),
+          &Shard.ImageByteMapAllocator.getAllocator(),
+          &Shard.IrAllocator.getAllocator(),
+          &Shard.ModuleAllocator.getAllocator(),
+          &Shard.ProxyBlockAllocator.getAllocator(),
+          &Shard.SectionAllocator.getAllocator(),
+          &Shard.SymbolAllocator.getAllocator()}) {
+      if (A->holdsSlabs())
+        return false;
+    }
+  }
+  for (auto& Shard : Allocators) {
+    Shard.NodeAllocator.setHugePages(Enable);
+    Shard.BlockAllocator.setHugePages(Enable);
+    Shard.DataObjectAllocator.setHugePages(Enable);
+    Shard.ImageByteMapAllocator.setHugePages(Enable);
+    Shard.IrAllocator.setHugePages(Enable);
+    Shard.ModuleAllocator.setHugePages(Enable);
+    Shard.ProxyBlockAllocator.setHugePages(Enable);
+    Shard.SectionAllocator.setHugePages(Enable);
+    Shard.SymbolAllocator.setHugePages(Enable);
+  }
+  return true;
+}
+
+template <typename T>
+static void addMemoryStats(NodeMemoryStats& Stats,
+                           const SpecificBumpPtrAllocator<T>& A) {
+  const BumpPtrAllocator& Impl = A.getAllocator();
+  NodeMemoryStats S;
+  // Slots of destroyed nodes count as free, since new nodes will reuse them.
+  size_t FreedBytes = A.getNumFree() * sizeof(T);
+  S.LiveCount = A.getNumAllocated();
+  S.SlabBytes = Impl.getTotalMemory();
+  S.UsedBytes = Impl.getBytesAllocated() - FreedBytes;
+  S.FreeBytes = Impl.getBytesRemaining() + FreedBytes;
+  S.WastedBytes = S.SlabBytes - S.UsedBytes - S.FreeBytes;
+  Stats += S;
+}
+
+ContextMemoryStats Context::getMemoryStats() const {
+  ContextMemoryStats Stats;
+  for (auto& Shard : Allocators) {
+    std::lock_guard<std::mutex> Lock(Shard.Mutex);
+    addMemoryStats(Stats.Nodes, Shard.NodeAllocator);
+    addMemoryStats(Stats.Blocks, Shard.BlockAllocator);
+    addMemoryStats(Stats.DataObjects, Shard.DataObjectAllocator);
+    addMemoryStats(Stats.ImageByteMaps, Shard.ImageByteMapAllocator);
+    addMemoryStats(Stats.IRs, Shard.IrAllocator);
+    addMemoryStats(Stats.Modules, Shard.ModuleAllocator);
+    addMemoryStats(Stats.ProxyBlocks, Shard.ProxyBlockAllocator);
+    addMemoryStats(Stats.Sections, Shard.SectionAllocator);
+    addMemoryStats(Stats.Symbols, Shard.SymbolAllocator);
+  }
+  Stats.RegistryBytes = sizeof(Registry);
+  for (const auto& Shard : Registry) {
+    std::lock_guard<std::mutex> Lock(Shard.Mutex);
+    Stats.RegisteredNodes += Shard.Nodes.size();
+    Stats.RegistryBytes += Shard.Nodes.getMemoryUsage();
+  }
+  for (const auto& Shard : InternedStrings) {
+    std::lock_guard<std::mutex> Lock(Shard.Mutex);
+    Stats.InternedStrings += Shard.Strings.size();
+    // Each string has a node in the map and one bucket pointer, and a heap
+    // buffer if it is too long to be stored inline.
+    using Entry = decltype(Shard.Strings)::value_type;
+    Stats.InternedStringBytes +=
+        Shard.Strings.bucket_count() * sizeof(void*) +
+        Shard.Strings.size() * (sizeof(Entry) + 2 * sizeof(void*));
+    for (const auto& [Str, Holds] : Shard.Strings)
+      if (Str.capacity() > std::string().capacity())
+        Stats.InternedStringBytes += Str.capacity() + 1;
+  }
+  Stats.IndexBytes = IndexHeap.getBytesAllocated();
+  return Stats;
+}
+
+void Context::addMappedFile(std::unique_ptr<MappedFile> F) {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  MappedFiles.push_back(std::move(F));
 }
 
 template <> void* Context::Allocate<Node>() const {
-  return NodeAllocator.Allocate();
+  AllocatorShard& Shard = threadShard();
+  std::lock_guard<std::mutex> Lock(Shard.Mutex);
+  return Shard.NodeAllocator.Allocate();
 }
 template <> void* Context::Allocate<Block>() const {
-  return BlockAllocator.Allocate();
+  AllocatorShard& Shard = threadShard();
+  std::lock_guard<std::mutex> Lock(Shard.Mutex);
+  return Shard.BlockAllocator.Allocate();
 }
 template <> void* Context::Allocate<DataObject>() const {
-  return DataObjectAllocator.Allocate();
+  AllocatorShard& Shard = threadShard();
+  std::lock_guard<std::mutex> Lock(Shard.Mutex);
+  return Shard.DataObjectAllocator.Allocate();
 }
 template <> void* Context::Allocate<ImageByteMap>() const {
-  return ImageByteMapAllocator.Allocate();
+  AllocatorShard& Shard = threadShard();
+  std::lock_guard<std::mutex> Lock(Shard.Mutex);
+  return Shard.ImageByteMapAllocator.Allocate();
 }
 template <> void* Context::Allocate<IR>() const {
-  return IrAllocator.Allocate();
+  AllocatorShard& Shard = threadShard();
+  std::lock_guard<std::mutex> Lock(Shard.Mutex);
+  return Shard.IrAllocator.Allocate();
 }
 template <> void* Context::Allocate<Module>() const {
-  return ModuleAllocator.Allocate();
+  AllocatorShard& Shard = threadShard();
+  std::lock_guard<std::mutex> Lock(Shard.Mutex);
+  return Shard.ModuleAllocator.Allocate();
 }
 template <> void* Context::Allocate<ProxyBlock>() const {
-  return ProxyBlockAllocator.Allocate();
+  AllocatorShard& Shard = threadShard();
+  std::lock_guard<std::mutex> Lock(Shard.Mutex);
+  return Shard.ProxyBlockAllocator.Allocate();
 }
 template <> void* Context::Allocate<Section>() const {
-  return SectionAllocator.Allocate();
+  AllocatorShard& Shard = threadShard();
+  std::lock_guard<std::mutex> Lock(Shard.Mutex);
+  return Shard.SectionAllocator.Allocate();
 }
 template <> void* Context::Allocate<Symbol>() const {
-  return SymbolAllocator.Allocate();
+  AllocatorShard& Shard = threadShard();
+  std::lock_guard<std::mutex> Lock(Shard.Mutex);
+  return Shard.SymbolAllocator.Allocate();
+}
+
+template <> void Context::Deallocate<Node>(void* P, size_t ShardIndex) const {
+  AllocatorShard& Shard = Allocators[ShardIndex];
+  std::lock_guard<std::mutex> Lock(Shard.Mutex);
+  Shard.NodeAllocator.Deallocate(static_cast<Node*>(P));
+}
+template <> void Context::Deallocate<Block>(void* P, size_t ShardIndex) const {
+  AllocatorShard& Shard = Allocators[ShardIndex];
+  std::lock_guard<std::mutex> Lock(Shard.Mutex);
+  Shard.BlockAllocator.Deallocate(static_cast<Block*>(P));
+}
+template <>
+void Context::Deallocate<DataObject>(void* P, size_t ShardIndex) const {
+  AllocatorShard& Shard = Allocators[ShardIndex];
+  std::lock_guard<std::mutex> Lock(Shard.Mutex);
+  Shard.DataObjectAllocator.Deallocate(static_cast<DataObject*>(P));
+}
+template <>
+void Context::Deallocate<ImageByteMap>(void* P, size_t ShardIndex) const {
+  AllocatorShard& Shard = Allocators[ShardIndex];
+  std::lock_guard<std::mutex> Lock(Shard.Mutex);
+  Shard.ImageByteMapAllocator.Deallocate(static_cast<ImageByteMap*>(P));
+}
+template <> void Context::Deallocate<IR>(void* P, size_t ShardIndex) const {
+  AllocatorShard& Shard = Allocators[ShardIndex];
+  std::lock_guard<std::mutex> Lock(Shard.Mutex);
+  Shard.IrAllocator.Deallocate(static_cast<IR*>(P));
+}
+template <> void Context::Deallocate<Module>(void* P, size_t ShardIndex) const {
+  AllocatorShard& Shard = Allocators[ShardIndex];
+  std::lock_guard<std::mutex> Lock(Shard.Mutex);
+  Shard.ModuleAllocator.Deallocate(static_cast<Module*>(P));
+}
+template <>
+void Context::Deallocate<ProxyBlock>(void* P, size_t ShardIndex) const {
+  AllocatorShard& Shard = Allocators[ShardIndex];
+  std::lock_guard<std::mutex> Lock(Shard.Mutex);
+  Shard.ProxyBlockAllocator.Deallocate(static_cast<ProxyBlock*>(P));
+}
+template <>
+void Context::Deallocate<Section>(void* P, size_t ShardIndex) const {
+  AllocatorShard& Shard = Allocators[ShardIndex];
+  std::lock_guard<std::mutex> Lock(Shard.Mutex);
+  Shard.SectionAllocator.Deallocate(static_cast<Section*>(P));
+}
+template <> void Context::Deallocate<Symbol>(void* P, size_t ShardIndex) const {
+  AllocatorShard& Shard = Allocators[ShardIndex];
+  std::lock_guard<std::mutex> Lock(Shard.Mutex);
+  Shard.SymbolAllocator.Deallocate(static_cast<Symbol*>(P));
 }
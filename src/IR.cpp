@@ -13,49 +13,526 @@
 //
 //===----------------------------------------------------------------------===//
 #include "IR.hpp"
+#include "MappedFile.hpp"
+#include "Parallel.hpp"
 #include "Serialization.hpp"
+#include <gtirb/Block.hpp>
 #include <gtirb/DataObject.hpp>
 #include <gtirb/ImageByteMap.hpp>
 #include <gtirb/Module.hpp>
+#include <gtirb/ProxyBlock.hpp>
 #include <gtirb/Section.hpp>
 #include <gtirb/Symbol.hpp>
 #include <gtirb/SymbolicExpression.hpp>
 #include <proto/IR.pb.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
 #include <google/protobuf/util/json_util.h>
+#include <climits>
 
 using namespace gtirb;
+using google::protobuf::Arena;
 
 void IR::toProtobuf(MessageType* Message) const {
   nodeUUIDToBytes(this, *Message->mutable_uuid());
+  loadPendingModules();
   containerToProtobuf(this->Modules, Message->mutable_modules());
 
   AuxDataContainer::toProtobuf(Message->mutable_aux_data_container());
 }
 
-IR* IR::fromProtobuf(Context& C, const MessageType& Message) {
+IR* IR::fromProtobuf(Context& C, const MessageType& Message,
+                     unsigned NumThreads) {
   auto* I = IR::Create(C);
   setNodeUUIDFromBytes(I, Message.uuid());
-  containerFromProtobuf(C, I->Modules, Message.modules());
+
+  // References saved as ids are resolved through the table, which finds the
+  // nodes created by each stage before the next stage begins.
+  UUIDTable Table(Message.uuid_table());
+
+  // Each stage may refer to nodes created by the previous stage in any
+  // module, so every module must finish one stage before the next begins.
+  const auto& Ms = Message.modules();
+  std::vector<Module*> Modules(Ms.size());
+  parallelFor(Modules.size(), NumThreads, [&](size_t Idx) {
+    Modules[Idx] = Module::nodesFromProtobuf(C, Ms[static_cast<int>(Idx)]);
+  });
+  Table.resolve(C);
+  parallelFor(Modules.size(), NumThreads, [&](size_t Idx) {
+    Modules[Idx]->symbolsFromProtobuf(C, Ms[static_cast<int>(Idx)], &Table);
+  });
+  Table.resolve(C);
+  parallelFor(Modules.size(), NumThreads, [&](size_t Idx) {
+    Modules[Idx]->symbolicExpressionsFromProtobuf(
+        C, Ms[static_cast<int>(Idx)], &Table);
+  });
+  I->Modules.insert(Modules.begin(), Modules.end());
 
   AuxDataContainer::fromProtobuf(static_cast<AuxDataContainer*>(I), C,
                                  Message.aux_data_container());
   return I;
 }
 
-void IR::save(std::ostream& Out) const {
-  MessageType Message;
-  this->toProtobuf(&Message);
-  Message.SerializeToOstream(&Out);
+namespace {
+// A minimal reader for the protobuf wire format, used to find the image bytes
+// in a memory-mapped file without copying them. Everything else is handed to
+// the generated protobuf parsers.
+struct WireField {
+  uint32_t Number;
+  uint32_t WireType;
+  // The start of the field's tag, the start of its payload (after the length
+  // prefix for length-delimited fields), and the end of the field.
+  const uint8_t* Start;
+  const uint8_t* Payload;
+  const uint8_t* End;
+};
+
+const uint32_t WireTypeVarint = 0;
+const uint32_t WireTypeFixed64 = 1;
+const uint32_t WireTypeLengthDelimited = 2;
+const uint32_t WireTypeFixed32 = 5;
+
+bool readVarint(const uint8_t*& Cur, const uint8_t* End, uint64_t& Value) {
+  Value = 0;
+  for (unsigned Shift = 0; Shift < 64; Shift += 7) {
+    if (Cur == End)
+      return false;
+    uint8_t Byte = *Cur++;
+    Value |= uint64_t(Byte & 0x7f) << Shift;
+    if (!(Byte & 0x80))
+      return true;
+  }
+  return false;
 }
 
-IR* IR::load(Context& C, std::istream& In) {
-  MessageType Message;
-  Message.ParseFromIstream(&In);
-  return IR::fromProtobuf(C, Message);
+bool readField(const uint8_t*& Cur, const uint8_t* End, WireField& F) {
+  F.Start = Cur;
+  uint64_t Tag;
+  if (!readVarint(Cur, End, Tag) || Tag >> 3 == 0 || Tag >> 3 > UINT32_MAX)
+    return false;
+  F.Number = static_cast<uint32_t>(Tag >> 3);
+  F.WireType = static_cast<uint32_t>(Tag & 7);
+  F.Payload = Cur;
+
+  uint64_t Size;
+  switch (F.WireType) {
+  case WireTypeVarint:
+    if (!readVarint(Cur, End, Size))
+      return false;
+    break;
+  case WireTypeFixed64:
+    if (End - Cur < 8)
+      return false;
+    Cur += 8;
+    break;
+  case WireTypeLengthDelimited:
+    if (!readVarint(Cur, End, Size) ||
+        Size > static_cast<uint64_t>(End - Cur))
+      return false;
+    F.Payload = Cur;
+    Cur += Size;
+    break;
+  case WireTypeFixed32:
+    if (End - Cur < 4)
+      return false;
+    Cur += 4;
+    break;
+  default:
+    // Groups are not used by GTIRB.
+    return false;
+  }
+  F.End = Cur;
+  return true;
+}
+
+bool mergeFrom(google::protobuf::MessageLite& Message, const uint8_t* Begin,
+               const uint8_t* End) {
+  if (Begin == End)
+    return true;
+  google::protobuf::io::CodedInputStream In(Begin,
+                                            static_cast<int>(End - Begin));
+  return Message.MergePartialFromCodedStream(&In) &&
+         In.ConsumedEntireMessage();
+}
+
+// Parse the message encoded in [Begin, End) into Message, except for
+// length-delimited fields numbered Special, whose payloads are passed to
+// Handler instead. Runs of other fields are parsed in as few calls as
+// possible.
+template <typename HandlerTy>
+bool walkMessage(google::protobuf::MessageLite& Message, const uint8_t* Begin,
+                 const uint8_t* End, uint32_t Special, HandlerTy Handler) {
+  const uint8_t* RunBegin = Begin;
+  const uint8_t* Cur = Begin;
+  while (Cur != End) {
+    WireField F;
+    if (!readField(Cur, End, F))
+      return false;
+    bool IsSpecial =
+        F.Number == Special && F.WireType == WireTypeLengthDelimited;
+    // CodedInputStream only accepts buffers whose size fits in an int.
+    bool RunTooLarge = F.End - RunBegin > INT_MAX;
+    if (IsSpecial || RunTooLarge) {
+      if (!mergeFrom(Message, RunBegin, F.Start))
+        return false;
+      RunBegin = F.Start;
+    }
+    if (IsSpecial) {
+      if (!Handler(F.Payload, F.End))
+        return false;
+      RunBegin = F.End;
+    } else if (F.End - RunBegin > INT_MAX) {
+      return false;
+    }
+  }
+  return mergeFrom(Message, RunBegin, End);
+}
+
+struct MappedRegion {
+  Addr Address;
+  const std::byte* Data;
+  size_t Size;
+};
+
+bool readRegion(const uint8_t* Begin, const uint8_t* End,
+                std::vector<MappedRegion>& Regions) {
+  MappedRegion R{Addr(), nullptr, 0};
+  const uint8_t* Cur = Begin;
+  while (Cur != End) {
+    WireField F;
+    if (!readField(Cur, End, F))
+      return false;
+    if (F.Number == 1 && F.WireType == WireTypeVarint) {
+      uint64_t Value;
+      const uint8_t* P = F.Payload;
+      readVarint(P, F.End, Value);
+      R.Address = Addr(Value);
+    } else if (F.Number == 2 && F.WireType == WireTypeLengthDelimited) {
+      R.Data = reinterpret_cast<const std::byte*>(F.Payload);
+      R.Size = static_cast<size_t>(F.End - F.Payload);
+    }
+  }
+  Regions.push_back(R);
+  return true;
+}
+} // namespace
+
+using RegionMap = std::map<std::string, std::vector<MappedRegion>>;
+
+// Parse a Module, except for the contents of byte map regions. Record where
+// those are in the file, keyed by the UUID of their ImageByteMap.
+static bool parseMappedModule(proto::Module& M, const uint8_t* Begin,
+                              const uint8_t* End, RegionMap& RegionsByUUID) {
+  return walkMessage(M, Begin, End, 8, [&](const uint8_t* IB,
+                                           const uint8_t* IE) {
+    auto* IBM = M.mutable_image_byte_map();
+    std::vector<MappedRegion> Regions;
+    bool Ok = walkMessage(*IBM, IB, IE, 2, [&](const uint8_t* BB,
+                                               const uint8_t* BE) {
+      return walkMessage(*IBM->mutable_byte_map(), BB, BE, 1,
+                         [&](const uint8_t* RB, const uint8_t* RE) {
+                           return readRegion(RB, RE, Regions);
+                         });
+    });
+    auto& Dest = RegionsByUUID[IBM->uuid()];
+    Dest.insert(Dest.end(), Regions.begin(), Regions.end());
+    return Ok;
+  });
+}
+
+static void addMappedRegions(Context& C, const RegionMap& RegionsByUUID) {
+  for (const auto& [ID, Regions] : RegionsByUUID) {
+    auto* IBM = dyn_cast_or_null<ImageByteMap>(
+        Node::getByUUID(C, uuidFromBytes(ID)));
+    if (!IBM)
+      continue;
+    for (const auto& R : Regions)
+      IBM->addMappedRegion(R.Address, R.Data, R.Size);
+  }
+}
+
+// The indexed format begins with these bytes. The first is not a valid
+// protobuf tag (wire type 7), so it cannot be mistaken for a plain IR.
+static const char IndexedMagic[] = {'G', 'T', 'I', 'R', 'B', 'I', 'D', 'X'};
+
+static bool isIndexed(const uint8_t* Begin, const uint8_t* End) {
+  return static_cast<size_t>(End - Begin) >= sizeof(IndexedMagic) &&
+         std::equal(std::begin(IndexedMagic), std::end(IndexedMagic), Begin);
+}
+
+// Parse the table of contents of an indexed file, and find the start of the
+// module payloads. Fails if any payload lies outside the file.
+static bool readIndex(const uint8_t* Begin, const uint8_t* End,
+                      proto::IRIndex& Index, const uint8_t*& Payloads) {
+  const uint8_t* Cur = Begin + sizeof(IndexedMagic);
+  uint64_t Size;
+  if (!readVarint(Cur, End, Size) ||
+      Size > static_cast<uint64_t>(End - Cur) || Size > INT_MAX ||
+      !mergeFrom(Index, Cur, Cur + Size))
+    return false;
+  Payloads = Cur + Size;
+
+  uint64_t Available = static_cast<uint64_t>(End - Payloads);
+  for (const auto& Entry : Index.modules())
+    if (Entry.offset() > Available ||
+        Entry.length() > Available - Entry.offset())
+      return false;
+  return true;
+}
+
+// Convert an indexed file into a plain IR message, calling ParseModule to
+// parse each module payload.
+template <typename ParseModuleTy>
+static bool indexedToProtobuf(const uint8_t* Begin, const uint8_t* End,
+                              Arena& TempArena, proto::IR& Message,
+                              ParseModuleTy ParseModule) {
+  auto& Index = *Arena::CreateMessage<proto::IRIndex>(&TempArena);
+  const uint8_t* Payloads;
+  if (!readIndex(Begin, End, Index, Payloads))
+    return false;
+  Message.set_uuid(Index.uuid());
+  Message.mutable_aux_data_container()->Swap(
+      Index.mutable_aux_data_container());
+  for (const auto& Entry : Index.modules()) {
+    const uint8_t* ModuleBegin = Payloads + Entry.offset();
+    if (!ParseModule(*Message.add_modules(), ModuleBegin,
+                     ModuleBegin + Entry.length()))
+      return false;
+  }
+  return true;
+}
+
+// Field numbers from IR.proto.
+static const int UuidField = 1;
+static const int ModulesField = 3;
+static const int AuxDataContainerField = 4;
+static const int UuidTableField = 5;
+
+void IR::save(std::ostream& Out, NodeReferences Refs) const {
+  // Write each part of the message as it is visited, rather than building
+  // the entire message in memory. The output parses to the same message as
+  // toProtobuf() produces, though fields may be in a different order.
+  google::protobuf::io::OstreamOutputStream Stream(&Out);
+  google::protobuf::io::CodedOutputStream Coded(&Stream);
+
+  std::string ID;
+  nodeUUIDToBytes(this, ID);
+  writeLengthDelimitedField(Coded, UuidField, ID.size());
+  Coded.WriteString(ID);
+  // The table is complete only once every module has been written, so it is
+  // written last.
+  UUIDTable Table;
+  UUIDTable* References = Refs == NodeReferences::ByIndex ? &Table : nullptr;
+  for (const Module& M : this->modules())
+    M.writeProtobufField(Coded, ModulesField, References);
+  writeLengthDelimitedField(Coded, AuxDataContainerField,
+                            AuxDataContainer::protobufSize());
+  AuxDataContainer::writeProtobuf(Coded);
+  if (!Table.bytes().empty()) {
+    writeLengthDelimitedField(Coded, UuidTableField, Table.bytes().size());
+    Coded.WriteString(Table.bytes());
+  }
+}
+
+IR* IR::load(Context& C, std::istream& In, unsigned NumThreads) {
+  // Temporary messages are allocated on an arena and released all at once.
+  Arena TempArena(serializationArenaOptions());
+  auto& Message = *Arena::CreateMessage<MessageType>(&TempArena);
+  if (In.peek() == IndexedMagic[0]) {
+    std::string Buffer(std::istreambuf_iterator<char>(In), {});
+    const auto* Begin = reinterpret_cast<const uint8_t*>(Buffer.data());
+    auto ParseModule = [](proto::Module& M, const uint8_t* MB,
+                          const uint8_t* ME) { return mergeFrom(M, MB, ME); };
+    if (!indexedToProtobuf(Begin, Begin + Buffer.size(), TempArena, Message,
+                           ParseModule))
+      return nullptr;
+  } else {
+    Message.ParseFromIstream(&In);
+  }
+  return IR::fromProtobuf(C, Message, NumThreads);
+}
+
+IR* IR::loadMapped(Context& C, const std::string& Path,
+                   unsigned NumThreads) {
+  auto File = MappedFile::open(Path);
+  if (!File)
+    return nullptr;
+  const auto* Begin = reinterpret_cast<const uint8_t*>(File->begin());
+  const auto* End = reinterpret_cast<const uint8_t*>(File->end());
+
+  Arena TempArena(serializationArenaOptions());
+  auto& Message = *Arena::CreateMessage<MessageType>(&TempArena);
+  RegionMap RegionsByUUID;
+  auto ParseModule = [&](proto::Module& M, const uint8_t* MB,
+                         const uint8_t* ME) {
+    return parseMappedModule(M, MB, ME, RegionsByUUID);
+  };
+  if (isIndexed(Begin, End)) {
+    if (!indexedToProtobuf(Begin, End, TempArena, Message, ParseModule))
+      return nullptr;
+  } else if (!walkMessage(Message, Begin, End, 3,
+                          [&](const uint8_t* MB, const uint8_t* ME) {
+                            return ParseModule(*Message.add_modules(), MB,
+                                               ME);
+                          })) {
+    return nullptr;
+  }
+
+  // Regions point into the mapping, so it must live as long as the Context.
+  C.addMappedFile(std::move(File));
+  IR* I = IR::fromProtobuf(C, Message, NumThreads);
+  addMappedRegions(C, RegionsByUUID);
+  return I;
+}
+
+IR* IR::loadLazy(Context& C, const std::string& Path) {
+  auto File = MappedFile::open(Path);
+  if (!File)
+    return nullptr;
+  const auto* Begin = reinterpret_cast<const uint8_t*>(File->begin());
+  const auto* End = reinterpret_cast<const uint8_t*>(File->end());
+  if (!isIndexed(Begin, End))
+    return IR::loadMapped(C, Path);
+
+  Arena TempArena(serializationArenaOptions());
+  auto& Index = *Arena::CreateMessage<proto::IRIndex>(&TempArena);
+  const uint8_t* Payloads;
+  if (!readIndex(Begin, End, Index, Payloads))
+    return nullptr;
+  C.addMappedFile(std::move(File));
+
+  auto* I = IR::Create(C);
+  setNodeUUIDFromBytes(I, Index.uuid());
+  AuxDataContainer::fromProtobuf(static_cast<AuxDataContainer*>(I), C,
+                                 Index.aux_data_container());
+  for (const auto& Entry : Index.modules()) {
+    const auto* ModuleBegin =
+        reinterpret_cast<const std::byte*>(Payloads + Entry.offset());
+    I->PendingModules.emplace(
+        Entry.name(),
+        PendingModule{&C, ModuleBegin, ModuleBegin + Entry.length()});
+  }
+  I->HasPending.store(!I->PendingModules.empty());
+  return I;
+}
+
+bool IR::loadModules() const {
+  loadPendingModules();
+  std::lock_guard<std::mutex> Lock(PendingMutex);
+  return !LoadFailed;
+}
+
+void IR::loadPendingModules() const {
+  if (!HasPending.load(std::memory_order_acquire))
+    return;
+  std::lock_guard<std::mutex> Lock(PendingMutex);
+  if (!PendingModules.empty())
+    loadPendingModules(PendingModules.begin(), PendingModules.end());
+  HasPending.store(false, std::memory_order_release);
+}
+
+std::pair<IR::ModuleSet::iterator, IR::ModuleSet::iterator>
+IR::findPendingModules(const std::string& Name) const {
+  if (!HasPending.load(std::memory_order_acquire))
+    return Modules.equal_range(Name);
+  std::lock_guard<std::mutex> Lock(PendingMutex);
+  auto [First, Last] = PendingModules.equal_range(Name);
+  loadPendingModules(First, Last);
+  if (PendingModules.empty())
+    HasPending.store(false, std::memory_order_release);
+  return Modules.equal_range(Name);
+}
+
+void IR::loadPendingModules(
+    std::multimap<std::string, PendingModule>::iterator First,
+    std::multimap<std::string, PendingModule>::iterator Last) const {
+  for (auto It = First; It != Last; ++It) {
+    const PendingModule& P = It->second;
+    Arena TempArena(serializationArenaOptions());
+    auto& Message = *Arena::CreateMessage<proto::Module>(&TempArena);
+    RegionMap RegionsByUUID;
+    // The table of contents was checked when the file was loaded, but the
+    // payload may still be malformed. Such modules are left out, and the
+    // failure is reported by loadModules().
+    if (!parseMappedModule(Message, reinterpret_cast<const uint8_t*>(P.Begin),
+                           reinterpret_cast<const uint8_t*>(P.End),
+                           RegionsByUUID)) {
+      LoadFailed = true;
+      continue;
+    }
+    Module* M = Module::fromProtobuf(*P.C, Message);
+    this->Modules.insert(M);
+    addMappedRegions(*P.C, RegionsByUUID);
+
+    // Referents in modules which are still pending are not found, so they are
+    // remembered and set once their module is loaded.
+    for (const auto& SM : Message.symbols()) {
+      if (SM.optional_payload_case() != proto::Symbol::kReferentUuid)
+        continue;
+      auto* S = dyn_cast_or_null<Symbol>(
+          Node::getByUUID(*P.C, uuidFromBytes(SM.uuid())));
+      if (S && S->hasReferent() && !S->getReferent<Node>())
+        this->UnresolvedReferents.push_back(
+            {M, S, uuidFromBytes(SM.referent_uuid())});
+    }
+  }
+  this->PendingModules.erase(First, Last);
+  resolveReferents();
+}
+
+void IR::resolveReferents() const {
+  auto Resolved = [this](const UnresolvedReferent& R) {
+    Node* N = Node::getByUUID(R.M->getContext(), R.Referent);
+    if (!N)
+      return false;
+    // The symbol may have been changed or moved since it was loaded.
+    if (!R.S->hasReferent() || R.S->getReferent<Node>())
+      return true;
+    auto Found = R.M->findSymbols(R.S->getName());
+    if (std::find_if(Found.begin(), Found.end(), [&R](const Symbol& S) {
+          return &S == R.S;
+        }) == Found.end())
+      return true;
+    if (auto* B = dyn_cast<Block>(N))
+      setReferent(*R.M, *R.S, B);
+    else if (auto* D = dyn_cast<DataObject>(N))
+      setReferent(*R.M, *R.S, D);
+    else if (auto* P = dyn_cast<ProxyBlock>(N))
+      setReferent(*R.M, *R.S, P);
+    return true;
+  };
+  auto& U = this->UnresolvedReferents;
+  U.erase(std::remove_if(U.begin(), U.end(), Resolved), U.end());
+}
+
+void IR::saveIndexed(std::ostream& Out) const {
+  Arena TempArena(serializationArenaOptions());
+  auto& Index = *Arena::CreateMessage<proto::IRIndex>(&TempArena);
+  nodeUUIDToBytes(this, *Index.mutable_uuid());
+  AuxDataContainer::toProtobuf(Index.mutable_aux_data_container());
+  uint64_t Offset = 0;
+  for (const Module& M : this->modules()) {
+    auto* Entry = Index.add_modules();
+    Entry->set_name(M.getName());
+    nodeUUIDToBytes(&M, *Entry->mutable_uuid());
+    Entry->set_isa_id(static_cast<proto::ISAID>(M.getISAID()));
+    Entry->set_offset(Offset);
+    Entry->set_length(M.protobufSize());
+    Offset += Entry->length();
+  }
+
+  google::protobuf::io::OstreamOutputStream Stream(&Out);
+  google::protobuf::io::CodedOutputStream Coded(&Stream);
+  Coded.WriteRaw(IndexedMagic, sizeof(IndexedMagic));
+  Coded.WriteVarint64(Index.ByteSizeLong());
+  Index.SerializeWithCachedSizes(&Coded);
+  for (const Module& M : this->modules())
+    M.writeProtobuf(Coded);
 }
 
 void IR::saveJSON(std::ostream& Out) const {
-  MessageType Message;
+  Arena TempArena(serializationArenaOptions());
+  auto& Message = *Arena::CreateMessage<MessageType>(&TempArena);
   this->toProtobuf(&Message);
   std::string S;
   google::protobuf::util::MessageToJsonString(Message, &S);
@@ -63,8 +540,8 @@ void IR::saveJSON(std::ostream& Out) const {
 }
 
 IR* IR::loadJSON(Context& C, std::istream& In) {
-  MessageType Message;
-  std::string S;
+  Arena TempArena(serializationArenaOptions());
+  auto& Message = *Arena::CreateMessage<MessageType>(&TempArena);
   google::protobuf::util::JsonStringToMessage(
       std::string(std::istreambuf_iterator<char>(In), {}), &Message);
   return IR::fromProtobuf(C, Message);
@@ -44,14 +44,37 @@ ImageByteMap::const_range ImageByteMap::data(Addr X, size_t Bytes) const {
   return ImageByteMap::const_range{};
 }
 
+// The fields of the ImageByteMap message, except for the byte map itself.
+static proto::ImageByteMap headerToProtobuf(const ImageByteMap& IBM) {
+  proto::ImageByteMap Message;
+  nodeUUIDToBytes(&IBM, *Message.mutable_uuid());
+  auto [Min, Max] = IBM.getAddrMinMax();
+  Message.set_addr_min(static_cast<uint64_t>(Min));
+  Message.set_addr_max(static_cast<uint64_t>(Max));
+  Message.set_base_address(static_cast<uint64_t>(IBM.getBaseAddress()));
+  Message.set_entry_point_address(
+      static_cast<uint64_t>(IBM.getEntryPointAddress()));
+  return Message;
+}
+
 void ImageByteMap::toProtobuf(MessageType* Message) const {
-  nodeUUIDToBytes(this, *Message->mutable_uuid());
+  *Message = headerToProtobuf(*this);
   this->BMap.toProtobuf(Message->mutable_byte_map());
-  Message->set_addr_min(static_cast<uint64_t>(this->EaMinMax.first));
-  Message->set_addr_max(static_cast<uint64_t>(this->EaMinMax.second));
-  Message->set_base_address(static_cast<uint64_t>(this->BaseAddress));
-  Message->set_entry_point_address(
-      static_cast<uint64_t>(this->EntryPointAddress));
+}
+
+// Field number from ImageByteMap.proto.
+static const int ByteMapField = 2;
+
+size_t ImageByteMap::protobufSize() const {
+  return headerToProtobuf(*this).ByteSizeLong() +
+         lengthDelimitedFieldSize(ByteMapField, this->BMap.protobufSize());
+}
+
+void ImageByteMap::writeProtobuf(
+    google::protobuf::io::CodedOutputStream& Out) const {
+  headerToProtobuf(*this).SerializeToCodedStream(&Out);
+  writeLengthDelimitedField(Out, ByteMapField, this->BMap.protobufSize());
+  this->BMap.writeProtobuf(Out);
 }
 
 ImageByteMap* ImageByteMap::fromProtobuf(Context& C,
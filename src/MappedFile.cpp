@@ -0,0 +1,102 @@
+//===- MappedFile.cpp -------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2018 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace gtirb;
+
+#ifdef _WIN32
+
+std::unique_ptr<MappedFile> MappedFile::open(const std::string& Path) {
+  std::unique_ptr<MappedFile> F(new MappedFile());
+  HANDLE File = CreateFileA(Path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (File == INVALID_HANDLE_VALUE)
+    return nullptr;
+  F->FileHandle = File;
+
+  LARGE_INTEGER Size;
+  if (!GetFileSizeEx(File, &Size))
+    return nullptr;
+  F->Size = static_cast<size_t>(Size.QuadPart);
+  // Empty files cannot be mapped, but they are still valid (empty) contents.
+  if (F->Size == 0)
+    return F;
+
+  F->MappingHandle =
+      CreateFileMappingA(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!F->MappingHandle)
+    return nullptr;
+  F->Data = static_cast<const std::byte*>(
+      MapViewOfFile(F->MappingHandle, FILE_MAP_READ, 0, 0, 0));
+  if (!F->Data)
+    return nullptr;
+  return F;
+}
+
+MappedFile::~MappedFile() {
+  if (Data)
+    UnmapViewOfFile(Data);
+  if (MappingHandle)
+    CloseHandle(MappingHandle);
+  if (FileHandle)
+    CloseHandle(FileHandle);
+}
+
+#else
+
+std::unique_ptr<MappedFile> MappedFile::open(const std::string& Path) {
+  int Fd = ::open(Path.c_str(), O_RDONLY);
+  if (Fd < 0)
+    return nullptr;
+
+  std::unique_ptr<MappedFile> F(new MappedFile());
+  struct stat St;
+  if (fstat(Fd, &St) != 0) {
+    ::close(Fd);
+    return nullptr;
+  }
+  F->Size = static_cast<size_t>(St.st_size);
+
+  // Empty files cannot be mapped, but they are still valid (empty) contents.
+  if (F->Size != 0) {
+    void* Ptr = mmap(nullptr, F->Size, PROT_READ, MAP_PRIVATE, Fd, 0);
+    if (Ptr == MAP_FAILED) {
+      ::close(Fd);
+      return nullptr;
+    }
+    F->Data = static_cast<const std::byte*>(Ptr);
+  }
+
+  // The mapping stays valid after the descriptor is closed.
+  ::close(Fd);
+  return F;
+}
+
+MappedFile::~MappedFile() {
+  if (Data)
+    munmap(const_cast<std::byte*>(Data), Size);
+}
+
+#endif
@@ -0,0 +1,64 @@
+//===- MappedFile.hpp -------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2018 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GTIRB_MAPPED_FILE_H
+#define GTIRB_MAPPED_FILE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace gtirb {
+
+/// \brief A read-only memory mapping of an entire file.
+///
+/// The mapping is released when the object is destroyed. Objects loaded from
+/// a mapped file may refer directly to its contents, so the \ref Context that
+/// owns them also owns the mapping.
+class MappedFile {
+public:
+  /// \brief Map a file into memory.
+  ///
+  /// \param Path  The path of the file to map.
+  ///
+  /// \return The mapping, or null if the file could not be opened or mapped.
+  static std::unique_ptr<MappedFile> open(const std::string& Path);
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile();
+
+  /// \brief Get the first byte of the mapped file.
+  const std::byte* begin() const { return Data; }
+
+  /// \brief Get the byte following the last byte of the mapped file.
+  const std::byte* end() const { return Data + Size; }
+
+  /// \brief Get the size of the mapped file in bytes.
+  size_t size() const { return Size; }
+
+private:
+  MappedFile() = default;
+
+  const std::byte* Data{nullptr};
+  size_t Size{0};
+#ifdef _WIN32
+  void* FileHandle{nullptr};
+  void* MappingHandle{nullptr};
+#endif
+};
+
+} // namespace gtirb
+
+#endif // GTIRB_MAPPED_FILE_H
@@ -13,22 +13,38 @@
 //
 //===----------------------------------------------------------------------===//
 #include "Module.hpp"
+#include "Parallel.hpp"
 #include "Serialization.hpp"
 #include <gtirb/Block.hpp>
 #include <gtirb/CFG.hpp>
 #include <gtirb/ImageByteMap.hpp>
 #include <gtirb/SymbolicExpression.hpp>
 #include <proto/Module.pb.h>
+#include <algorithm>
 #include <map>
+#include <tuple>
+#include <utility>
+#include <variant>
 
 using namespace gtirb;
+using google::protobuf::Arena;
 
-Module::Module(Context& C)
-    : AuxDataContainer(C, Kind::Module), ImageBytes(ImageByteMap::Create(C)) {}
+Module::Module(Context& C) : Module(C, std::string()) {}
 
 Module::Module(Context& C, const std::string& X)
     : AuxDataContainer(C, Kind::Module), Name(X),
-      ImageBytes(ImageByteMap::Create(C)) {}
+      Blocks(BlockSet::allocator_type(C.getMemoryResource())),
+      BlockAddrs(C.getMemoryResource()),
+      Data(DataSet::allocator_type(C.getMemoryResource())),
+      DataAddrs(C.getMemoryResource()), ImageBytes(ImageByteMap::Create(C)),
+      ProxyBlocks(ProxyBlockSet::allocator_type(C.getMemoryResource())),
+      Sections(SectionSet::allocator_type(C.getMemoryResource())),
+      SectionAddrs(C.getMemoryResource()),
+      Symbols(SymbolSet::allocator_type(C.getMemoryResource())),
+      SymbolicOperands(
+          SymbolicExpressionSet::allocator_type(C.getMemoryResource())),
+      SymbolReferences(
+          SymbolReferenceSet::allocator_type(C.getMemoryResource())) {}
 
 gtirb::ImageByteMap& Module::getImageByteMap() { return *this->ImageBytes; }
 
@@ -45,7 +61,284 @@ void Module::addCfgNode(CfgNode* N) {
     assert("attempted to add invalid CfgNode");
 }
 
-void Module::toProtobuf(MessageType* Message) const {
+bool Module::removeProxyBlock(ProxyBlock* P) {
+  if (ProxyBlocks.erase(P) == 0)
+    return false;
+  removeVertex(P, Cfg);
+  detachSymbols(P);
+  return true;
+}
+
+void Module::eraseProxyBlock(ProxyBlock* P) {
+  if (removeProxyBlock(P))
+    Context::Destroy(P);
+}
+
+bool Module::removeSymbol(Symbol* S) {
+  return Symbols.get<by_pointer>().erase(S) != 0;
+}
+
+void Module::eraseSymbol(Symbol* S) {
+  if (removeSymbol(S)) {
+    removeSymbolicExpressions(S);
+    Context::Destroy(S);
+  }
+}
+
+bool Module::removeBlock(Block* B) {
+  if (Blocks.get<by_pointer>().erase(B) == 0)
+    return false;
+  BlockAddrs.erase(B);
+  removeVertex(B, Cfg);
+  detachSymbols(B);
+  return true;
+}
+
+void Module::eraseBlock(Block* B) {
+  if (removeBlock(B))
+    Context::Destroy(B);
+}
+
+bool Module::removeData(DataObject* DO) {
+  if (Data.get<by_pointer>().erase(DO) == 0)
+    return false;
+  DataAddrs.erase(DO);
+  detachSymbols(DO);
+  return true;
+}
+
+void Module::eraseData(DataObject* DO) {
+  if (removeData(DO))
+    Context::Destroy(DO);
+}
+
+bool Module::removeSection(Section* S) {
+  if (Sections.get<by_pointer>().erase(S) == 0)
+    return false;
+  SectionAddrs.erase(S);
+  return true;
+}
+
+void Module::eraseSection(Section* S) {
+  if (removeSection(S))
+    Context::Destroy(S);
+}
+
+void Module::detachSymbols(const Node* N) {
+  auto [First, Last] = Symbols.get<by_referent>().equal_range(N);
+  // Changing a referent moves the symbol within this index, so collect the
+  // symbols first.
+  std::vector<Symbol*> Referring(First, Last);
+  auto& Index = Symbols.get<by_pointer>();
+  for (Symbol* S : Referring) {
+    Index.modify(Index.find(S), [](Symbol* Sym) {
+      if (std::optional<Addr> A = Sym->getAddress())
+        Sym->Payload = *A;
+      else
+        Sym->Payload = std::monostate();
+    });
+  }
+}
+
+void Module::removeSymbolicExpressions(const Symbol* S) {
+  auto Addrs = getSymbolicExpressionAddrs(*S);
+  // Removing an expression also removes its entry from SymbolReferences.
+  std::vector<Addr> Referring(Addrs.begin(), Addrs.end());
+  for (Addr A : Referring)
+    removeSymbolicExpression(A);
+}
+
+template <typename SetTy, typename IndexTy, typename NodeTy>
+void Module::insertSorted(SetTy& Set, IndexTy& AddrIndex,
+                          std::vector<NodeTy*>& New) {
+  // Order the new nodes as the address index does, then drop duplicates and
+  // nodes already in the module.
+  auto Less = [](const NodeTy* A, const NodeTy* B) {
+    return std::make_tuple(A->getAddress(), A->getSize(), A) <
+           std::make_tuple(B->getAddress(), B->getSize(), B);
+  };
+  if (!std::is_sorted(New.begin(), New.end(), Less))
+    std::sort(New.begin(), New.end(), Less);
+  New.erase(std::unique(New.begin(), New.end()), New.end());
+  auto& ByPointer = Set.template get<by_pointer>();
+  New.erase(std::remove_if(New.begin(), New.end(),
+                           [&ByPointer](NodeTy* N) {
+                             return ByPointer.count(N) != 0;
+                           }),
+            New.end());
+
+  // Inserting each node just after the one before it takes amortized
+  // constant time unless existing nodes lie in between.
+  ByPointer.reserve(Set.size() + New.size());
+  auto& ByAddress = Set.template get<by_address>();
+  auto Hint = ByAddress.end();
+  for (NodeTy* N : New) {
+    auto It = ByAddress.insert(Hint, N);
+    Hint = std::next(It);
+  }
+  AddrIndex.insert(New.begin(), New.end());
+}
+
+void Module::insertBlocks(std::vector<Block*> Bs) {
+  insertSorted(Blocks, BlockAddrs, Bs);
+  Cfg[boost::graph_bundle].reserve(num_vertices(Cfg) + Bs.size());
+  for (Block* B : Bs)
+    addVertex(B, Cfg);
+}
+
+void Module::insertData(std::vector<DataObject*> Ds) {
+  insertSorted(Data, DataAddrs, Ds);
+}
+
+void Module::insertProxyBlocks(std::vector<ProxyBlock*> Ps) {
+  ProxyBlocks.reserve(ProxyBlocks.size() + Ps.size());
+  Cfg[boost::graph_bundle].reserve(num_vertices(Cfg) + Ps.size());
+  for (ProxyBlock* P : Ps)
+    if (ProxyBlocks.insert(P).second)
+      addVertex(P, Cfg);
+}
+
+void Module::insertSections(std::vector<Section*> Ss) {
+  insertSorted(Sections, SectionAddrs, Ss);
+}
+
+// Split Sorted into up to NumThreads pieces of at least a few thousand
+// addresses, and call F(Begin, End) for each piece on its own thread.
+template <typename FunctionTy>
+static void forEachChunk(const std::vector<Addr>& Sorted, unsigned NumThreads,
+                         FunctionTy F) {
+  const size_t MinChunk = 4096;
+  size_t Chunks = std::min<size_t>(std::max(NumThreads, 1u),
+                                   Sorted.size() / MinChunk + 1);
+  parallelFor(Chunks, NumThreads, [&](size_t C) {
+    F(Sorted.size() * C / Chunks, Sorted.size() * (C + 1) / Chunks);
+  });
+}
+
+template <typename RangeTy, typename IndexTy>
+static std::vector<RangeTy> findSortedAddrs(const IndexTy& AddrIndex,
+                                            const std::vector<Addr>& Sorted,
+                                            unsigned NumThreads) {
+  std::vector<RangeTy> Result(Sorted.size());
+  forEachChunk(Sorted, NumThreads, [&](size_t Begin, size_t End) {
+    AddrIndex.findSorted(Sorted.data() + Begin, Sorted.data() + End,
+                         [&Result, Begin](size_t I, auto Found) {
+                           Result[Begin + I] =
+                               RangeTy(Found.begin(), Found.end());
+                         });
+  });
+  return Result;
+}
+
+std::vector<Module::block_subrange>
+Module::findBlocks(const std::vector<Addr>& Sorted, unsigned NumThreads) {
+  return findSortedAddrs<block_subrange>(BlockAddrs, Sorted, NumThreads);
+}
+
+std::vector<Module::const_block_subrange>
+Module::findBlocks(const std::vector<Addr>& Sorted,
+                   unsigned NumThreads) const {
+  return findSortedAddrs<const_block_subrange>(BlockAddrs, Sorted,
+                                               NumThreads);
+}
+
+std::vector<Module::data_object_subrange>
+Module::findData(const std::vector<Addr>& Sorted, unsigned NumThreads) {
+  return findSortedAddrs<data_object_subrange>(DataAddrs, Sorted, NumThreads);
+}
+
+std::vector<Module::const_data_object_subrange>
+Module::findData(const std::vector<Addr>& Sorted, unsigned NumThreads) const {
+  return findSortedAddrs<const_data_object_subrange>(DataAddrs, Sorted,
+                                                     NumThreads);
+}
+
+template <typename RangeTy, typename IndexTy>
+static std::vector<RangeTy> findSortedSymbols(const IndexTy& ByAddress,
+                                              const std::vector<Addr>& Sorted,
+                                              unsigned NumThreads) {
+  assert(std::is_sorted(Sorted.begin(), Sorted.end()) &&
+         "addresses must be sorted");
+  std::vector<RangeTy> Result(Sorted.size());
+  forEachChunk(Sorted, NumThreads, [&](size_t Begin, size_t End) {
+    if (Begin == End)
+      return;
+    // Walking the symbols only pays off if there are many addresses.
+    size_t LogN = 1;
+    while ((size_t(1) << LogN) <= ByAddress.size())
+      ++LogN;
+    if ((End - Begin) * LogN < ByAddress.size()) {
+      for (size_t I = Begin; I < End; ++I) {
+        auto Found = ByAddress.equal_range(Sorted[I]);
+        Result[I] = RangeTy(Found.first, Found.second);
+      }
+      return;
+    }
+
+    auto It = ByAddress.lower_bound(Sorted[Begin]);
+    for (size_t I = Begin; I < End; ++I) {
+      std::optional<Addr> X = Sorted[I];
+      while (It != ByAddress.end() && (*It)->getAddress() < X)
+        ++It;
+      auto Last = It;
+      while (Last != ByAddress.end() && (*Last)->getAddress() == X)
+        ++Last;
+      Result[I] = RangeTy(It, Last);
+    }
+  });
+  return Result;
+}
+
+std::vector<Module::symbol_addr_range>
+Module::findSymbols(const std::vector<Addr>& Sorted, unsigned NumThreads) {
+  return findSortedSymbols<symbol_addr_range>(Symbols.get<by_address>(),
+                                              Sorted, NumThreads);
+}
+
+std::vector<Module::const_symbol_addr_range>
+Module::findSymbols(const std::vector<Addr>& Sorted,
+                    unsigned NumThreads) const {
+  return findSortedSymbols<const_symbol_addr_range>(Symbols.get<by_address>(),
+                                                    Sorted, NumThreads);
+}
+
+namespace {
+// The symbols a symbolic expression mentions; unused entries are null.
+class ReferencedSymbols {
+public:
+  using SymbolPair = std::pair<const Symbol*, const Symbol*>;
+
+  SymbolPair operator()(const SymStackConst& Val) const {
+    return {Val.Sym, nullptr};
+  }
+
+  SymbolPair operator()(const SymAddrConst& Val) const {
+    return {Val.Sym, nullptr};
+  }
+
+  SymbolPair operator()(const SymAddrAddr& Val) const {
+    return {Val.Sym1, Val.Sym2};
+  }
+};
+} // namespace
+
+void Module::addSymbolReferences(Addr X, const SymbolicExpression& SE) {
+  auto [Sym1, Sym2] = std::visit(ReferencedSymbols(), SE);
+  if (Sym1)
+    SymbolReferences.emplace(Sym1, X);
+  if (Sym2)
+    SymbolReferences.emplace(Sym2, X);
+}
+
+void Module::removeSymbolReferences(Addr X, const SymbolicExpression& SE) {
+  auto [Sym1, Sym2] = std::visit(ReferencedSymbols(), SE);
+  if (Sym1)
+    SymbolReferences.erase({Sym1, X});
+  if (Sym2)
+    SymbolReferences.erase({Sym2, X});
+}
+
+void Module::fieldsToProtobuf(MessageType* Message) const {
   nodeUUIDToBytes(this, *Message->mutable_uuid());
   Message->set_binary_path(this->BinaryPath);
   Message->set_preferred_addr(static_cast<uint64_t>(this->PreferredAddr));
@@ -53,8 +346,7 @@ void Module::toProtobuf(MessageType* Message) const {
   Message->set_file_format(static_cast<proto::FileFormat>(this->FileFormat));
   Message->set_isa_id(static_cast<proto::ISAID>(this->IsaID));
   Message->set_name(this->Name);
-  this->ImageBytes->toProtobuf(Message->mutable_image_byte_map());
-  *Message->mutable_cfg() = gtirb::toProtobuf(this->Cfg);
+  gtirb::toProtobuf(this->Cfg, Message->mutable_cfg());
   sequenceToProtobuf(block_begin(), block_end(), Message->mutable_blocks());
   sequenceToProtobuf(data_begin(), data_end(), Message->mutable_data());
   sequenceToProtobuf(ProxyBlocks.begin(), ProxyBlocks.end(),
@@ -63,9 +355,71 @@ void Module::toProtobuf(MessageType* Message) const {
                      Message->mutable_sections());
   containerToProtobuf(Symbols, Message->mutable_symbols());
   containerToProtobuf(SymbolicOperands, Message->mutable_symbolic_operands());
+}
+
+void Module::toProtobuf(MessageType* Message) const {
+  this->fieldsToProtobuf(Message);
+  this->ImageBytes->toProtobuf(Message->mutable_image_byte_map());
   AuxDataContainer::toProtobuf(Message->mutable_aux_data_container());
 }
 
+// Field numbers from Module.proto.
+static const int ImageByteMapField = 8;
+static const int AuxDataContainerField = 14;
+
+// The serialized size of a Module, given the sizes of its parts.
+static size_t moduleSize(size_t FieldsSize, size_t ImageBytesSize,
+                         size_t AuxDataSize) {
+  return FieldsSize +
+         lengthDelimitedFieldSize(ImageByteMapField, ImageBytesSize) +
+         lengthDelimitedFieldSize(AuxDataContainerField, AuxDataSize);
+}
+
+static void writeModule(google::protobuf::io::CodedOutputStream& Out,
+                        const proto::Module& Fields, const ImageByteMap& IBM,
+                        size_t ImageBytesSize, const AuxDataContainer& AD,
+                        size_t AuxDataSize) {
+  Fields.SerializeWithCachedSizes(&Out);
+  writeLengthDelimitedField(Out, ImageByteMapField, ImageBytesSize);
+  IBM.writeProtobuf(Out);
+  writeLengthDelimitedField(Out, AuxDataContainerField, AuxDataSize);
+  AD.writeProtobuf(Out);
+}
+
+size_t Module::protobufSize() const {
+  Arena TempArena(serializationArenaOptions());
+  auto& Fields = *Arena::CreateMessage<MessageType>(&TempArena);
+  this->fieldsToProtobuf(&Fields);
+  return moduleSize(Fields.ByteSizeLong(), this->ImageBytes->protobufSize(),
+                    AuxDataContainer::protobufSize());
+}
+
+void Module::writeProtobuf(google::protobuf::io::CodedOutputStream& Out) const {
+  Arena TempArena(serializationArenaOptions());
+  auto& Fields = *Arena::CreateMessage<MessageType>(&TempArena);
+  this->fieldsToProtobuf(&Fields);
+  Fields.ByteSizeLong();
+  writeModule(Out, Fields, *this->ImageBytes, this->ImageBytes->protobufSize(),
+              *this, AuxDataContainer::protobufSize());
+}
+
+void Module::writeProtobufField(google::protobuf::io::CodedOutputStream& Out,
+                                int FieldNumber,
+                                UUIDTable* References) const {
+  Arena TempArena(serializationArenaOptions());
+  auto& Fields = *Arena::CreateMessage<MessageType>(&TempArena);
+  this->fieldsToProtobuf(&Fields);
+  if (References)
+    References->compact(Fields);
+  size_t ImageBytesSize = this->ImageBytes->protobufSize();
+  size_t AuxDataSize = AuxDataContainer::protobufSize();
+  writeLengthDelimitedField(
+      Out, FieldNumber,
+      moduleSize(Fields.ByteSizeLong(), ImageBytesSize, AuxDataSize));
+  writeModule(Out, Fields, *this->ImageBytes, ImageBytesSize, *this,
+              AuxDataSize);
+}
+
 // FIXME: improve containerFromProtobuf so it can handle a pair where one
 // element is a pointer to a Node subclass.
 template <class T, class U, class V, class W>
@@ -80,7 +434,7 @@ static void nodeMapFromProtobuf(Context& C, std::map<T, U*>& Values,
   });
 }
 
-Module* Module::fromProtobuf(Context& C, const MessageType& Message) {
+Module* Module::nodesFromProtobuf(Context& C, const MessageType& Message) {
   Module* M = Module::Create(C);
   setNodeUUIDFromBytes(M, Message.uuid());
   M->BinaryPath = Message.binary_path();
@@ -90,19 +444,60 @@ Module* Module::fromProtobuf(Context& C, const MessageType& Message) {
   M->IsaID = static_cast<ISAID>(Message.isa_id());
   M->Name = Message.name();
   M->ImageBytes = ImageByteMap::fromProtobuf(C, Message.image_byte_map());
+  // Nodes are serialized in address order, so each index can be built in a
+  // single pass.
+  std::vector<Block*> Bs;
+  Bs.reserve(Message.blocks_size());
   for (const auto& Elt : Message.blocks())
-    M->addBlock(Block::fromProtobuf(C, Elt));
+    Bs.push_back(Block::fromProtobuf(C, Elt));
+  M->insertBlocks(std::move(Bs));
+  std::vector<DataObject*> Ds;
+  Ds.reserve(Message.data_size());
   for (const auto& Elt : Message.data())
-    M->addData(DataObject::fromProtobuf(C, Elt));
+    Ds.push_back(DataObject::fromProtobuf(C, Elt));
+  M->insertData(std::move(Ds));
+  std::vector<ProxyBlock*> Ps;
+  Ps.reserve(Message.proxies_size());
   for (const auto& Elt : Message.proxies())
-    M->addProxyBlock(ProxyBlock::fromProtobuf(C, Elt));
+    Ps.push_back(ProxyBlock::fromProtobuf(C, Elt));
+  M->insertProxyBlocks(std::move(Ps));
+  std::vector<Section*> Ss;
+  Ss.reserve(Message.sections_size());
   for (const auto& Elt : Message.sections())
-    M->addSection(Section::fromProtobuf(C, Elt));
-  containerFromProtobuf(C, M->Symbols, Message.symbols());
-  gtirb::fromProtobuf(C, M->Cfg, Message.cfg());
-  // Create SymbolicExpressions after the Symbols they reference.
-  containerFromProtobuf(C, M->SymbolicOperands, Message.symbolic_operands());
+    Ss.push_back(Section::fromProtobuf(C, Elt));
+  M->insertSections(std::move(Ss));
+  M->buildPageTables();
   AuxDataContainer::fromProtobuf(static_cast<AuxDataContainer*>(M), C,
                                  Message.aux_data_container());
   return M;
 }
+
+void Module::symbolsFromProtobuf(Context& C, const MessageType& Message,
+                                 const UUIDTable* References) {
+  this->Symbols.clear();
+  for (const auto& M : Message.symbols())
+    this->Symbols.insert(Symbol::fromProtobuf(C, M, References));
+  gtirb::fromProtobuf(C, this->Cfg, Message.cfg(), References);
+}
+
+void Module::symbolicExpressionsFromProtobuf(Context& C,
+                                             const MessageType& Message,
+                                             const UUIDTable* References) {
+  this->SymbolicOperands.clear();
+  for (const auto& M : Message.symbolic_operands()) {
+    SymbolicExpressionElement Val;
+    gtirb::fromProtobuf(C, Val.first, M.first);
+    gtirb::fromProtobuf(C, Val.second, M.second, References);
+    this->SymbolicOperands.insert(std::move(Val));
+  }
+  for (const auto& [X, SE] : this->SymbolicOperands)
+    addSymbolReferences(X, SE);
+}
+
+Module* Module::fromProtobuf(Context& C, const MessageType& Message) {
+  Module* M = Module::nodesFromProtobuf(C, Message);
+  M->symbolsFromProtobuf(C, Message, nullptr);
+  // Create SymbolicExpressions after the Symbols they reference.
+  M->symbolicExpressionsFromProtobuf(C, Message, nullptr);
+  return M;
+}
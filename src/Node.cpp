@@ -19,14 +19,12 @@
 #include "gtirb/Module.hpp"
 #include "gtirb/Section.hpp"
 #include "gtirb/SymbolicExpression.hpp"
-#include <boost/uuid/uuid_generators.hpp>
 
 using namespace gtirb;
 
 Node::Node(Context& C, Kind Knd)
-    : K(Knd), Uuid(boost::uuids::random_generator()()), Ctx(&C) {
-  Ctx->registerNode(Uuid, this);
-}
+    : K(Knd), Uuid(C.registerNewNode(this)), Ctx(&C),
+      HasUuid(!Uuid.is_nil()) {}
 
 Node::~Node() noexcept { Ctx->unregisterNode(this); }
 
@@ -36,5 +34,6 @@ void Node::setUUID(UUID X) {
 
   Ctx->unregisterNode(this);
   this->Uuid = X;
+  HasUuid.store(true, std::memory_order_release);
   Ctx->registerNode(Uuid, this);
 }
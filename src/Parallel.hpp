@@ -0,0 +1,68 @@
+//===- Parallel.hpp ---------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2018 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GTIRB_PARALLEL_H
+#define GTIRB_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gtirb {
+
+// Call F(0) through F(N - 1), spread across up to NumThreads threads.
+//
+// If a call throws, no further calls are started, and once every thread has
+// finished the first exception is rethrown on the calling thread.
+template <typename FunctionTy>
+void parallelFor(size_t N, unsigned NumThreads, FunctionTy F) {
+  size_t ThreadCount = std::min<size_t>(NumThreads, N);
+  if (ThreadCount <= 1) {
+    for (size_t I = 0; I < N; ++I)
+      F(I);
+    return;
+  }
+
+  std::atomic<size_t> Next{0};
+  std::mutex ErrorMutex;
+  std::exception_ptr Error;
+  auto Worker = [&]() {
+    try {
+      for (size_t I = Next++; I < N; I = Next++)
+        F(I);
+    } catch (...) {
+      Next = N;
+      std::lock_guard<std::mutex> Lock(ErrorMutex);
+      if (!Error)
+        Error = std::current_exception();
+    }
+  };
+  std::vector<std::thread> Threads;
+  Threads.reserve(ThreadCount - 1);
+  for (size_t T = 1; T < ThreadCount; ++T)
+    Threads.emplace_back(Worker);
+  Worker();
+  for (auto& T : Threads)
+    T.join();
+  if (Error)
+    std::rethrow_exception(Error);
+}
+
+} // namespace gtirb
+
+#endif // GTIRB_PARALLEL_H
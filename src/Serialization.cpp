@@ -14,6 +14,10 @@
 //===----------------------------------------------------------------------===//
 #include "Serialization.hpp"
 #include "Node.hpp"
+#include <gtirb/Context.hpp>
+#include <proto/Module.pb.h>
+#include <google/protobuf/message_lite.h>
+#include <algorithm>
 
 namespace gtirb {
 UUID uuidFromBytes(const std::string& Bytes) {
@@ -38,6 +42,113 @@ void setNodeUUIDFromBytes(Node* Node, const std::string& Bytes) {
   Node->setUUID(uuidFromBytes(Bytes));
 }
 
+UUIDTable::UUIDTable(const std::string& Table) : Bytes(Table) {
+  Nodes.resize(Bytes.size() / sizeof(UUID::data), nullptr);
+}
+
+uint64_t UUIDTable::getId(const std::string& UuidBytes) {
+  if (UuidBytes.empty())
+    return 0;
+  auto [It, Inserted] = Ids.emplace(uuidFromBytes(UuidBytes), Ids.size() + 1);
+  if (Inserted)
+    Bytes += UuidBytes;
+  return It->second;
+}
+
+void UUIDTable::compact(proto::Module& Message) {
+  auto* Cfg = Message.mutable_cfg();
+  for (const auto& V : Cfg->vertices())
+    Cfg->add_vertex_ids(getId(V));
+  Cfg->clear_vertices();
+  for (auto& E : *Cfg->mutable_edges()) {
+    E.set_source_id(getId(E.source_uuid()));
+    E.set_target_id(getId(E.target_uuid()));
+    E.clear_source_uuid();
+    E.clear_target_uuid();
+  }
+
+  for (auto& S : *Message.mutable_symbols())
+    if (S.optional_payload_case() == proto::Symbol::kReferentUuid)
+      S.set_referent_id(getId(S.referent_uuid()));
+
+  for (auto& Entry : *Message.mutable_symbolic_operands()) {
+    auto& Expr = Entry.second;
+    if (Expr.has_stack_const()) {
+      auto* Val = Expr.mutable_stack_const();
+      Val->set_symbol_id(getId(Val->symbol_uuid()));
+      Val->clear_symbol_uuid();
+    } else if (Expr.has_addr_const()) {
+      auto* Val = Expr.mutable_addr_const();
+      Val->set_symbol_id(getId(Val->symbol_uuid()));
+      Val->clear_symbol_uuid();
+    } else if (Expr.has_addr_addr()) {
+      auto* Val = Expr.mutable_addr_addr();
+      Val->set_symbol1_id(getId(Val->symbol1_uuid()));
+      Val->set_symbol2_id(getId(Val->symbol2_uuid()));
+      Val->clear_symbol1_uuid();
+      Val->clear_symbol2_uuid();
+    }
+  }
+}
+
+void UUIDTable::resolve(Context& C) {
+  for (size_t I = 0; I < Nodes.size(); ++I) {
+    if (!Nodes[I]) {
+      UUID Id;
+      std::copy_n(Bytes.begin() + I * sizeof(Id.data), sizeof(Id.data),
+                  std::begin(Id.data));
+      Nodes[I] = Node::getByUUID(C, Id);
+    }
+  }
+}
+
+Node* nodeFromId(const UUIDTable* References, uint64_t Id) {
+  return References ? References->getNode(Id) : nullptr;
+}
+
+google::protobuf::ArenaOptions serializationArenaOptions() {
+  google::protobuf::ArenaOptions Options;
+  Options.start_block_size = 64 * 1024;
+  Options.max_block_size = 16 * 1024 * 1024;
+  return Options;
+}
+
+static uint32_t lengthDelimitedTag(int FieldNumber) {
+  return (static_cast<uint32_t>(FieldNumber) << 3) | 2;
+}
+
+size_t lengthDelimitedFieldSize(int FieldNumber, size_t Size) {
+  using google::protobuf::io::CodedOutputStream;
+  return CodedOutputStream::VarintSize32(lengthDelimitedTag(FieldNumber)) +
+         CodedOutputStream::VarintSize64(Size) + Size;
+}
+
+void writeLengthDelimitedField(google::protobuf::io::CodedOutputStream& Out,
+                               int FieldNumber, size_t Size) {
+  Out.WriteTag(lengthDelimitedTag(FieldNumber));
+  Out.WriteVarint64(Size);
+}
+
+void writeRawBytes(google::protobuf::io::CodedOutputStream& Out,
+                   const void* Data, size_t Size) {
+  // WriteRaw takes an int size.
+  const size_t MaxChunk = size_t(1) << 30;
+  const char* Bytes = static_cast<const char*>(Data);
+  while (Size > 0) {
+    size_t Chunk = std::min(Size, MaxChunk);
+    Out.WriteRaw(Bytes, static_cast<int>(Chunk));
+    Bytes += Chunk;
+    Size -= Chunk;
+  }
+}
+
+void writeMessageField(google::protobuf::io::CodedOutputStream& Out,
+                       int FieldNumber,
+                       const google::protobuf::MessageLite& Message) {
+  writeLengthDelimitedField(Out, FieldNumber, Message.ByteSizeLong());
+  Message.SerializeWithCachedSizes(&Out);
+}
+
 uint64_t toProtobuf(const Addr Val) { return static_cast<uint64_t>(Val); }
 
 std::string toProtobuf(const std::string& Val) { return Val; }
@@ -18,9 +18,18 @@
 #include <gtirb/Addr.hpp>
 #include <gtirb/Block.hpp>
 #include <gtirb/Node.hpp>
+#include <google/protobuf/arena.h>
+#include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/map.h>
 #include <google/protobuf/repeated_field.h>
+#include <boost/functional/hash.hpp>
 #include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace proto {
+class Module;
+}
 
 // Utilities for serialization
 
@@ -56,6 +65,126 @@ void nodeUUIDToBytes(const Node* Node, std::string& Bytes);
 /// \return void
 void setNodeUUIDFromBytes(Node* Node, const std::string& Bytes);
 
+/// \brief Get the options for arenas holding temporary messages while loading
+/// or saving.
+///
+/// These messages can be very large, so blocks grow beyond protobuf's default
+/// maximum size to keep the number of allocations down.
+///
+/// \return The arena options.
+google::protobuf::ArenaOptions serializationArenaOptions();
+
+/// \brief A table of the UUIDs of nodes referred to within an IR saved with
+/// \ref NodeReferences::ByIndex.
+///
+/// Each reference is stored as an id, which is one plus the index of the
+/// node's UUID in the table, so that zero means there is no reference. While
+/// saving, ids are assigned to UUIDs as they are first seen. While loading,
+/// each UUID is looked up once and references become a vector lookup.
+class UUIDTable {
+public:
+  /// \brief Create an empty table, to which UUIDs are added while saving.
+  UUIDTable() = default;
+
+  /// \brief Create a table from its saved form, for loading.
+  ///
+  /// \param Bytes  The UUIDs in the table, 16 bytes each.
+  explicit UUIDTable(const std::string& Bytes);
+
+  /// \brief Get the id of a UUID, adding it to the table if it is new.
+  ///
+  /// \param UuidBytes  The raw bytes of the UUID.
+  ///
+  /// \return The id of the UUID, or zero if UuidBytes is empty.
+  uint64_t getId(const std::string& UuidBytes);
+
+  /// \brief Replace every node reference in a module message with an id.
+  ///
+  /// \param Message  The module message to modify.
+  ///
+  /// \return void
+  void compact(proto::Module& Message);
+
+  /// \brief Get the saved form of the table.
+  const std::string& bytes() const { return Bytes; }
+
+  /// \brief Find the nodes for entries which have not been found yet.
+  ///
+  /// Loading resolves the table after each stage, as nodes become available.
+  ///
+  /// \param C  The Context holding the nodes.
+  ///
+  /// \return void
+  void resolve(Context& C);
+
+  /// \brief Get the node referred to by an id.
+  ///
+  /// \param Id  The id of the node.
+  ///
+  /// \return The node, or null if Id is zero or its node was not found.
+  Node* getNode(uint64_t Id) const {
+    return Id != 0 && Id <= Nodes.size() ? Nodes[Id - 1] : nullptr;
+  }
+
+private:
+  std::string Bytes;
+  std::unordered_map<UUID, uint64_t, boost::hash<UUID>> Ids;
+  std::vector<Node*> Nodes;
+};
+
+/// \brief Get the node referred to by an id in the \ref UUIDTable of the IR
+/// being loaded.
+///
+/// \param References  The table of the IR being loaded, or null if the IR
+///                    was saved without one.
+/// \param Id          The id of the node.
+///
+/// \return The node, or null if there is no such node.
+Node* nodeFromId(const UUIDTable* References, uint64_t Id);
+
+// Helpers for writing the protobuf wire format directly to a stream, so large
+// messages can be saved without building them in memory first.
+
+/// \brief Get the encoded size of a length-delimited field.
+///
+/// \param FieldNumber  The number of the field.
+/// \param Size         The size of the field's payload in bytes.
+///
+/// \return The size of the field's tag, length, and payload.
+size_t lengthDelimitedFieldSize(int FieldNumber, size_t Size);
+
+/// \brief Write the tag and length of a length-delimited field.
+///
+/// \param Out          The stream to write to.
+/// \param FieldNumber  The number of the field.
+/// \param Size         The size of the field's payload in bytes.
+///
+/// \return void
+void writeLengthDelimitedField(google::protobuf::io::CodedOutputStream& Out,
+                               int FieldNumber, size_t Size);
+
+/// \brief Write raw bytes, which may be larger than CodedOutputStream can
+/// write in a single call.
+///
+/// \param Out   The stream to write to.
+/// \param Data  The bytes to write.
+/// \param Size  The number of bytes to write.
+///
+/// \return void
+void writeRawBytes(google::protobuf::io::CodedOutputStream& Out,
+                   const void* Data, size_t Size);
+
+/// \brief Write a complete message as a length-delimited field.
+///
+/// \param Out          The stream to write to.
+/// \param FieldNumber  The number of the field.
+/// \param Message      The message to write.
+///
+/// \return void
+void writeMessageField(google::protobuf::io::CodedOutputStream& Out,
+                       int FieldNumber,
+                       const google::protobuf::MessageLite& Message);
+
 // Generic protobuf conversion for IR classes which implement toProtobuf.
 template <typename T> typename T::MessageType toProtobuf(const T& Val) {
   typename T::MessageType Message;
@@ -138,19 +267,33 @@ addElement(ContainerType& Container, T&& Element) {
   Container.insert(std::move(Element));
 }
 
+// Serialize IR classes which implement toProtobuf directly into a new element
+// of a repeated field. This avoids a temporary message, and allocates the
+// element on the container's arena if it has one.
+template <typename T, typename MessageT>
+auto addElementFrom(google::protobuf::RepeatedPtrField<MessageT>* Container,
+                    const T& Val, int)
+    -> decltype(Val.toProtobuf(std::declval<MessageT*>())) {
+  Val.toProtobuf(Container->Add());
+}
+template <typename T, typename ContainerT>
+void addElementFrom(ContainerT* Container, const T& Val, long) {
+  addElement(Container, toProtobuf(Val));
+}
+
 // Convert the contents of a Container into protobuf messages.
 template <typename ContainerT, typename MessageT>
 void containerToProtobuf(const ContainerT& Values, MessageT* Message) {
   initContainer(Message, Values.size());
   std::for_each(Values.begin(), Values.end(), [Message](const auto& N) {
-    addElement(Message, toProtobuf(deref_if_ptr(N)));
+    addElementFrom(Message, deref_if_ptr(N), 0);
   });
 }
 
 template <typename IterT, typename MessageT>
 void sequenceToProtobuf(IterT First, IterT Last, MessageT* Message) {
   while (First != Last)
-    addElement(Message, toProtobuf(deref_if_ptr(*First++)));
+    addElementFrom(Message, deref_if_ptr(*First++), 0);
 }
 
 // Generic conversion from protobuf for IR classes which implement fromProtobuf;
@@ -19,6 +19,8 @@
 
 using namespace gtirb;
 
+Symbol::~Symbol() noexcept { getContext().releaseString(*Name); }
+
 class StorePayload {
 public:
   StorePayload(Symbol::MessageType* Message) : M(Message) {}
@@ -35,11 +37,12 @@ private:
 void Symbol::toProtobuf(MessageType* Message) const {
   nodeUUIDToBytes(this, *Message->mutable_uuid());
   std::visit(StorePayload(Message), Payload);
-  Message->set_name(this->Name);
+  Message->set_name(*this->Name);
   Message->set_storage_kind(static_cast<proto::StorageKind>(this->Storage));
 }
 
-Symbol* Symbol::fromProtobuf(Context& C, const MessageType& Message) {
+Symbol* Symbol::fromProtobuf(Context& C, const MessageType& Message,
+                             const UUIDTable* References) {
   Symbol* S = Symbol::Create(C, Message.name());
   switch (Message.optional_payload_case()) {
   case proto::Symbol::kValue:
@@ -48,6 +51,9 @@ Symbol* Symbol::fromProtobuf(Context& C, const MessageType& Message) {
   case proto::Symbol::kReferentUuid:
     S->Payload = Node::getByUUID(C, uuidFromBytes(Message.referent_uuid()));
     break;
+  case proto::Symbol::kReferentId:
+    S->Payload = nodeFromId(References, Message.referent_id());
+    break;
   default:
       /* nothing to do */;
   }
@@ -62,7 +62,11 @@ proto::SymbolicExpression toProtobuf(const SymbolicExpression& Value) {
 }
 
 namespace {
-Symbol* symbolFromProto(Context& C, const std::string& Bytes) {
+Symbol* symbolFromProto(Context& C, const UUIDTable* References,
+                        const std::string& Bytes, uint64_t Id) {
+  if (Id != 0) {
+    return dyn_cast_or_null<Symbol>(nodeFromId(References, Id));
+  }
   if (Bytes.empty()) {
     return nullptr;
   }
@@ -72,23 +76,29 @@ Symbol* symbolFromProto(Context& C, const std::string& Bytes) {
 } // namespace
 
 void fromProtobuf(Context& C, SymbolicExpression& Result,
-                  const proto::SymbolicExpression& Message) {
+                  const proto::SymbolicExpression& Message,
+                  const UUIDTable* References) {
   switch (Message.value_case()) {
   case proto::SymbolicExpression::kStackConst: {
     const auto& Val = Message.stack_const();
-    Result = SymStackConst{Val.offset(), symbolFromProto(C, Val.symbol_uuid())};
+    Result = SymStackConst{
+        Val.offset(),
+        symbolFromProto(C, References, Val.symbol_uuid(), Val.symbol_id())};
     break;
   }
   case proto::SymbolicExpression::kAddrConst: {
     const auto& Val = Message.addr_const();
-    Result = SymAddrConst{Val.offset(), symbolFromProto(C, Val.symbol_uuid())};
+    Result = SymAddrConst{
+        Val.offset(),
+        symbolFromProto(C, References, Val.symbol_uuid(), Val.symbol_id())};
     break;
   }
   case proto::SymbolicExpression::kAddrAddr: {
     const auto& Val = Message.addr_addr();
-    Result = SymAddrAddr{Val.scale(), Val.offset(),
-                         symbolFromProto(C, Val.symbol1_uuid()),
-                         symbolFromProto(C, Val.symbol2_uuid())};
+    Result = SymAddrAddr{
+        Val.scale(), Val.offset(),
+        symbolFromProto(C, References, Val.symbol1_uuid(), Val.symbol1_id()),
+        symbolFromProto(C, References, Val.symbol2_uuid(), Val.symbol2_id())};
     break;
   }
   case proto::SymbolicExpression::VALUE_NOT_SET:
@@ -0,0 +1,143 @@
+//===- NodeRegistry.bench.cpp -----------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2018 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+//
+// Measure the throughput of registering, finding, and unregistering nodes by
+// UUID, comparing NodeRegistry against a std::map and timing the same
+// operations through the public Context API, including tearing it down.
+//
+// Usage: bench-node-registry [NUM_NODES]    (default: 10000000)
+//
+//===----------------------------------------------------------------------===//
+#include <gtirb/Context.hpp>
+#include <gtirb/Node.hpp>
+#include <gtirb/NodeRegistry.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace gtirb;
+
+// Time F and report the rate at which it performs NumOps operations.
+template <typename FunctionTy>
+static void measure(const char* Name, size_t NumOps, FunctionTy F) {
+  auto Start = std::chrono::steady_clock::now();
+  F();
+  std::chrono::duration<double> Elapsed =
+      std::chrono::steady_clock::now() - Start;
+  std::cout << Name << ": " << Elapsed.count() << " s, "
+            << NumOps / Elapsed.count() / 1e6 << " M ops/s\n";
+}
+
+int main(int argc, char** argv) {
+  size_t NumNodes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+  std::cout << "Nodes: " << NumNodes << "\n";
+
+  // Use a fixed seed, and a generator much cheaper than the one used for
+  // nodes, so only the registries are measured.
+  std::mt19937_64 Rng(0);
+  std::vector<UUID> IDs(NumNodes);
+  for (auto& ID : IDs) {
+    for (size_t I = 0; I < sizeof(ID.data); I += sizeof(uint64_t)) {
+      uint64_t R = Rng();
+      std::copy_n(reinterpret_cast<const uint8_t*>(&R), sizeof(R),
+                  ID.data + I);
+    }
+  }
+  // Look up in a different order than insertion, as a loader would.
+  std::vector<UUID> Shuffled(IDs);
+  std::shuffle(Shuffled.begin(), Shuffled.end(), Rng);
+
+  Context Ctx;
+  Node* Value = Node::Create(Ctx);
+  size_t Found = 0;
+
+  {
+    std::map<UUID, Node*> M;
+    measure("std::map insert", NumNodes, [&]() {
+      for (const auto& ID : IDs)
+        M[ID] = Value;
+    });
+    measure("std::map find", NumNodes, [&]() {
+      for (const auto& ID : Shuffled)
+        Found += M.find(ID) != M.end();
+    });
+    measure("std::map erase", NumNodes, [&]() {
+      for (const auto& ID : Shuffled)
+        M.erase(ID);
+    });
+  }
+
+  {
+    NodeRegistry R;
+    measure("NodeRegistry insert", NumNodes, [&]() {
+      for (const auto& ID : IDs)
+        R.insert(ID, Value);
+    });
+    measure("NodeRegistry find", NumNodes, [&]() {
+      for (const auto& ID : Shuffled)
+        Found += R.find(ID) != nullptr;
+    });
+    std::cout << "NodeRegistry memory: " << R.getMemoryUsage() / 1e6
+              << " MB\n";
+    measure("NodeRegistry erase", NumNodes, [&]() {
+      for (const auto& ID : Shuffled)
+        R.erase(ID);
+    });
+  }
+
+  {
+    // Node creation includes generating UUIDs and allocating, as well as
+    // registering.
+    Context NodeCtx;
+    std::vector<UUID> NodeIDs(NumNodes);
+    measure("Node::Create", NumNodes, [&]() {
+      for (auto& ID : NodeIDs)
+        ID = Node::Create(NodeCtx)->getUUID();
+    });
+    std::shuffle(NodeIDs.begin(), NodeIDs.end(), Rng);
+    measure("Node::getByUUID", NumNodes, [&]() {
+      for (const auto& ID : NodeIDs)
+        Found += Node::getByUUID(NodeCtx, ID) != nullptr;
+    });
+  }
+
+  {
+    // With lazy UUIDs, nodes which are never looked up are not registered.
+    Context NodeCtx;
+    NodeCtx.setLazyUUIDs(true);
+    measure("Node::Create (lazy UUIDs)", NumNodes, [&]() {
+      for (size_t I = 0; I < NumNodes; ++I)
+        Node::Create(NodeCtx);
+    });
+  }
+
+  {
+    // Destroying a Context releases its nodes without unregistering them one
+    // at a time.
+    auto NodeCtx = std::make_unique<Context>();
+    for (size_t I = 0; I < NumNodes; ++I)
+      Node::Create(*NodeCtx);
+    measure("Context teardown", NumNodes, [&]() { NodeCtx.reset(); });
+  }
+
+  // Keep the lookups from being optimized away.
+  std::cout << "Found: " << Found << "\n";
+  return 0;
+}
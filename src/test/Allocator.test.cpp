@@ -59,3 +59,100 @@ TEST(Unit_Allocator, deallocate) {
     EXPECT_EQ(AllocTest::DtorCount, AllocTest::CtorCount);
   }
 }
+
+TEST(Unit_Allocator, resetReusesSlabs) {
+  AllocTest::CtorCount = AllocTest::DtorCount = 0;
+  Allocator A;
+  // Fill several slabs.
+  for (int I = 0; I < 2000; I++)
+    new (A) AllocTest;
+  size_t NumSlabs = A.getAllocator().GetNumSlabs();
+  size_t TotalMemory = A.getAllocator().getTotalMemory();
+  ASSERT_GT(NumSlabs, 1);
+
+  A.Reset();
+  EXPECT_EQ(AllocTest::DtorCount, 2000);
+  EXPECT_EQ(A.getNumAllocated(), 0);
+  EXPECT_EQ(A.getAllocator().getTotalMemory(), TotalMemory);
+  EXPECT_EQ(A.getAllocator().getBytesRemaining(), TotalMemory);
+
+  // Allocating the same objects again needs no new memory.
+  for (int I = 0; I < 2000; I++)
+    new (A) AllocTest;
+  EXPECT_EQ(A.getAllocator().GetNumSlabs(), NumSlabs);
+  EXPECT_EQ(A.getAllocator().getTotalMemory(), TotalMemory);
+
+  // Keep only one slab.
+  A.Reset(1);
+  EXPECT_EQ(AllocTest::DtorCount, 4000);
+  EXPECT_EQ(A.getAllocator().getTotalMemory(), 4096);
+}
+
+TEST(Unit_Allocator, freeListReusesSlots) {
+  AllocTest::CtorCount = AllocTest::DtorCount = 0;
+  {
+    Allocator A;
+    auto* T1 = new (A) AllocTest;
+    auto* T2 = new (A) AllocTest;
+    size_t BytesAllocated = A.getAllocator().getBytesAllocated();
+
+    T1->~AllocTest();
+    A.Deallocate(T1);
+    EXPECT_EQ(A.getNumAllocated(), 1);
+    EXPECT_EQ(A.getNumFree(), 1);
+
+    // The freed slot is reused before any new memory.
+    EXPECT_EQ(new (A) AllocTest, T1);
+    EXPECT_EQ(A.getNumFree(), 0);
+    EXPECT_EQ(A.getAllocator().getBytesAllocated(), BytesAllocated);
+
+    // A slot still free when the allocator is destroyed is not destroyed
+    // again.
+    T2->~AllocTest();
+    A.Deallocate(T2);
+  }
+  EXPECT_EQ(AllocTest::CtorCount, 3);
+  EXPECT_EQ(AllocTest::DtorCount, 3);
+}
+
+TEST(Unit_Allocator, hugePages) {
+  AllocTest::CtorCount = AllocTest::DtorCount = 0;
+  {
+    Allocator A;
+    A.setHugePages(true);
+    // Slabs double in size from 4 KiB, so the tenth fills a huge page.
+    size_t Count = 0;
+    while (A.getAllocator().getTotalMemory() < HugePageSize) {
+      auto* T = new (A) AllocTest;
+      T->Data.fill('x');
+      ++Count;
+    }
+    EXPECT_EQ(A.getAllocator().GetNumSlabs(), 10);
+    EXPECT_EQ(A.getAllocator().getTotalMemory(), 2 * HugePageSize - 4096);
+
+    A.Reset(1);
+    EXPECT_EQ(AllocTest::DtorCount, Count);
+    EXPECT_EQ(A.getAllocator().getTotalMemory(), 4096);
+    // The retained slab keeps the policy fixed.
+    EXPECT_FALSE(A.setHugePages(false));
+    EXPECT_TRUE(A.getAllocator().getHugePages());
+    new (A) AllocTest;
+  }
+  EXPECT_EQ(AllocTest::DtorCount, AllocTest::CtorCount);
+}
+
+struct TeardownTest {
+  ~TeardownTest() { ++AllocTest::DtorCount; }
+};
+template <> struct needs_destruction<TeardownTest> : std::false_type {};
+
+TEST(Unit_Allocator, skipDestructors) {
+  AllocTest::DtorCount = 0;
+  {
+    SpecificBumpPtrAllocator<TeardownTest> A;
+    for (int I = 0; I < 2000; I++)
+      new (A.Allocate()) TeardownTest;
+    A.Reset();
+  }
+  EXPECT_EQ(AllocTest::DtorCount, 0);
+}
@@ -218,6 +218,48 @@ TEST(Unit_CFG, edgeLabels) {
   }
 }
 
+TEST(Unit_CFG, removeVertex) {
+  CFG Cfg;
+  auto B1 = Block::Create(Ctx, Addr(1), 2);
+  auto B2 = Block::Create(Ctx, Addr(3), 4);
+  auto B3 = Block::Create(Ctx, Addr(7), 4);
+  auto P1 = ProxyBlock::Create(Ctx);
+  for (CfgNode* N : {(CfgNode*)B1, (CfgNode*)B2, (CfgNode*)B3, (CfgNode*)P1})
+    addVertex(N, Cfg);
+  addEdge(B1, B2, Cfg);
+  addEdge(B2, P1, Cfg);
+  addEdge(B1, P1, Cfg);
+  auto E = addEdge(P1, B3, Cfg);
+  Cfg[*E] = std::make_tuple(ConditionalEdge::OnTrue, DirectEdge::IsDirect,
+                            EdgeType::Branch);
+  addEdge(P1, P1, Cfg);
+
+  EXPECT_TRUE(removeVertex(B2, Cfg));
+  EXPECT_FALSE(removeVertex(B2, Cfg));
+  EXPECT_FALSE(getVertex(B2, Cfg));
+  EXPECT_EQ(num_vertices(Cfg), 3);
+
+  // The last vertex moved into the removed vertex's place, keeping its edges
+  // and their labels.
+  EXPECT_EQ(*getVertex(P1, Cfg), 1);
+  EXPECT_EQ(Cfg[*getVertex(B1, Cfg)], B1);
+  EXPECT_EQ(Cfg[*getVertex(B3, Cfg)], B3);
+  EXPECT_EQ(Cfg[*getVertex(P1, Cfg)], P1);
+  EXPECT_EQ(num_edges(Cfg), 3);
+  EXPECT_EQ(out_degree(*getVertex(B1, Cfg), Cfg), 1);
+  EXPECT_EQ(in_degree(*getVertex(P1, Cfg), Cfg), 2);
+  EXPECT_EQ(out_degree(*getVertex(P1, Cfg), Cfg), 2);
+  for (auto Edge : make_iterator_range(out_edges(*getVertex(P1, Cfg), Cfg))) {
+    if (Cfg[target(Edge, Cfg)] == B3) {
+      EXPECT_EQ(std::get<EdgeType>(*Cfg[Edge]), EdgeType::Branch);
+    }
+  }
+
+  EXPECT_TRUE(removeVertex(P1, Cfg));
+  EXPECT_EQ(num_vertices(Cfg), 2);
+  EXPECT_EQ(num_edges(Cfg), 0);
+}
+
 TEST(Unit_CFG, protobufRoundTrip) {
   CFG Result;
   proto::CFG Message;
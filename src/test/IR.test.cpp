@@ -13,6 +13,7 @@
 //
 //===----------------------------------------------------------------------===//
 #include <gtirb/AuxData.hpp>
+#include <gtirb/Block.hpp>
 #include <gtirb/Context.hpp>
 #include <gtirb/DataObject.hpp>
 #include <gtirb/IR.hpp>
@@ -22,7 +23,10 @@
 #include <gtirb/Symbol.hpp>
 #include <gtirb/SymbolicExpression.hpp>
 #include <proto/IR.pb.h>
+#include <google/protobuf/util/message_differencer.h>
 #include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
 
 using namespace gtirb;
 
@@ -196,6 +200,38 @@ TEST(Unit_IR, protobufRoundTrip) {
   EXPECT_NE(Result->getAuxData("test"), nullptr);
 }
 
+TEST(Unit_IR, protobufRoundTripOnArena) {
+  google::protobuf::Arena Arena;
+  auto* Message = google::protobuf::Arena::CreateMessage<proto::IR>(&Arena);
+  UUID MainID;
+
+  {
+    Context InnerCtx;
+    IR* Original = IR::Create(InnerCtx);
+    Module* M = Module::Create(InnerCtx);
+    M->getImageByteMap().setAddrMinMax({Addr(100), Addr(200)});
+    M->getImageByteMap().setData(Addr(100), 8, std::byte(1));
+    M->addBlock(Block::Create(InnerCtx, Addr(100), 4));
+    M->addSymbol(Symbol::Create(InnerCtx, Addr(100), "sym"));
+    Original->addModule(M);
+    Original->addAuxData("test", AuxData());
+
+    MainID = Original->begin()->getUUID();
+    Original->toProtobuf(Message);
+  }
+  EXPECT_EQ(Message->modules(0).GetArena(), &Arena);
+  EXPECT_EQ(Message->modules(0).blocks(0).GetArena(), &Arena);
+
+  Context InnerCtx;
+  IR* Result = IR::fromProtobuf(InnerCtx, *Message);
+  EXPECT_EQ(Result->begin()->getUUID(), MainID);
+  EXPECT_EQ(std::distance(Result->begin()->block_begin(),
+                          Result->begin()->block_end()),
+            1);
+  EXPECT_EQ(Result->begin()->getImageByteMap().data(Addr(100), 8).size(), 8);
+  EXPECT_EQ(Result->getAuxDataSize(), 1);
+}
+
 TEST(Unit_IR, jsonRoundTrip) {
   UUID MainID;
   std::ostringstream Out;
@@ -223,6 +259,434 @@ TEST(Unit_IR, jsonRoundTrip) {
   EXPECT_NE(Result->getAuxData("test"), nullptr);
 }
 
+TEST(Unit_IR, saveWithLazyUuids) {
+  std::ostringstream Out;
+  UUID BlockID;
+
+  {
+    Context InnerCtx;
+    InnerCtx.setLazyUUIDs(true);
+    IR* Original = IR::Create(InnerCtx);
+    Module* M = Module::Create(InnerCtx, "m");
+    Block* B = Block::Create(InnerCtx, Addr(0x1000), 4);
+    M->addBlock(B);
+    M->addSymbol(Symbol::Create(InnerCtx, B, "b"));
+    Original->addModule(M);
+    Original->save(Out);
+    BlockID = B->getUUID();
+  }
+
+  Context InnerCtx;
+  std::istringstream In(Out.str());
+  IR* Result = IR::load(InnerCtx, In);
+  const Module& M = *Result->begin();
+  ASSERT_NE(M.symbol_begin(), M.symbol_end());
+  const Block* B = M.symbol_begin()->getReferent<Block>();
+  ASSERT_NE(B, nullptr);
+  EXPECT_EQ(B->getUUID(), BlockID);
+  EXPECT_EQ(Node::getByUUID(InnerCtx, BlockID), B);
+}
+
+TEST(Unit_IR, saveMatchesProtobuf) {
+  IR* Original = IR::Create(Ctx);
+  for (const char* Name : {"a", "b"}) {
+    Module* M = Module::Create(Ctx, Name);
+    M->getImageByteMap().setAddrMinMax({Addr(0), Addr(0x2000)});
+    M->getImageByteMap().setData(Addr(0), std::byte(1));
+    M->getImageByteMap().setData(Addr(0x1000), 0x100, std::byte(2));
+    M->addBlock(Block::Create(Ctx, Addr(0x1000), 4));
+    M->addData(DataObject::Create(Ctx, Addr(0x1004), 4));
+    M->addSymbol(Symbol::Create(Ctx, Addr(0x1000), "sym"));
+    M->addAuxData("module", std::vector<int64_t>{1, 2, 3});
+    M->addAuxData("empty", AuxData());
+    Original->addModule(M);
+  }
+  Original->addAuxData("ir", std::string("value"));
+
+  std::ostringstream Out;
+  Original->save(Out);
+  proto::IR Saved;
+  ASSERT_TRUE(Saved.ParseFromString(Out.str()));
+
+  proto::IR Expected;
+  Original->toProtobuf(&Expected);
+  EXPECT_TRUE(
+      google::protobuf::util::MessageDifferencer::Equals(Saved, Expected));
+}
+
+TEST(Unit_IR, loadMapped) {
+  const std::string Path = "Unit_IR_loadMapped.gtirb";
+  UUID MainID;
+
+  {
+    Context InnerCtx;
+    IR* Original = IR::Create(InnerCtx);
+    Module* M = Module::Create(InnerCtx);
+    M->getImageByteMap().setAddrMinMax({Addr(100), Addr(200)});
+    M->getImageByteMap().setData(
+        Addr(100), std::array<std::byte, 4>{std::byte(1), std::byte(2),
+                                            std::byte(3), std::byte(4)});
+    Original->addModule(M);
+    Original->addAuxData("test", AuxData());
+
+    MainID = Original->begin()->getUUID();
+    std::ofstream Out(Path, std::ios::binary);
+    Original->save(Out);
+  }
+
+  {
+    Context InnerCtx;
+    IR* Result = IR::loadMapped(InnerCtx, Path);
+    ASSERT_NE(Result, nullptr);
+    EXPECT_EQ(Result->begin()->getUUID(), MainID);
+    EXPECT_EQ(Result->getAuxDataSize(), 1);
+
+    auto& BM = Result->begin()->getImageByteMap();
+    EXPECT_EQ(BM.getAddrMinMax(), std::make_pair(Addr(100), Addr(200)));
+    EXPECT_EQ(BM.data(Addr(100), 4),
+              (std::vector<std::byte>{std::byte(1), std::byte(2),
+                                      std::byte(3), std::byte(4)}));
+
+    // Writing to a mapped region copies it, leaving the file untouched.
+    EXPECT_TRUE(BM.setData(Addr(101), std::byte(9)));
+    EXPECT_TRUE(BM.setData(Addr(104), std::byte(5)));
+    EXPECT_EQ(BM.data(Addr(100), 5),
+              (std::vector<std::byte>{std::byte(1), std::byte(9),
+                                      std::byte(3), std::byte(4),
+                                      std::byte(5)}));
+  }
+
+  {
+    Context InnerCtx;
+    IR* Result = IR::loadMapped(InnerCtx, Path);
+    ASSERT_NE(Result, nullptr);
+    EXPECT_EQ(Result->begin()->getImageByteMap().data(Addr(100), 4),
+              (std::vector<std::byte>{std::byte(1), std::byte(2),
+                                      std::byte(3), std::byte(4)}));
+  }
+  std::remove(Path.c_str());
+
+  EXPECT_EQ(IR::loadMapped(Ctx, "does-not-exist.gtirb"), nullptr);
+}
+
+TEST(Unit_IR, parallelLoadResolvesCrossModuleReferences) {
+  std::ostringstream Out;
+  const int NumModules = 8;
+  std::vector<UUID> BlockIDs, SymbolIDs;
+
+  {
+    Context InnerCtx;
+    IR* Original = IR::Create(InnerCtx);
+    std::vector<Module*> Modules;
+    std::vector<Block*> Blocks;
+    for (int I = 0; I < NumModules; ++I) {
+      Module* M = Module::Create(InnerCtx, "m" + std::to_string(I));
+      Block* B = Block::Create(InnerCtx, Addr(0x1000 * I), 4);
+      M->addBlock(B);
+      Modules.push_back(M);
+      Blocks.push_back(B);
+      BlockIDs.push_back(B->getUUID());
+    }
+    // Each module has a symbol referring to the next module's block, and a
+    // symbolic expression referring to the previous module's symbol.
+    std::vector<Symbol*> Symbols;
+    for (int I = 0; I < NumModules; ++I) {
+      Symbol* S =
+          Symbol::Create(InnerCtx, Blocks[(I + 1) % NumModules], "next");
+      Modules[I]->addSymbol(S);
+      Symbols.push_back(S);
+      SymbolIDs.push_back(S->getUUID());
+    }
+    for (int I = 0; I < NumModules; ++I) {
+      Modules[I]->addSymbolicExpression(
+          Addr(0x1000 * I),
+          SymAddrConst{0, Symbols[(I + NumModules - 1) % NumModules]});
+      Original->addModule(Modules[I]);
+    }
+    Original->save(Out);
+  }
+
+  for (unsigned NumThreads : {1u, 4u}) {
+    Context InnerCtx;
+    std::istringstream In(Out.str());
+    IR* Result = IR::load(InnerCtx, In, NumThreads);
+    EXPECT_EQ(std::distance(Result->begin(), Result->end()), NumModules);
+
+    int I = 0;
+    for (const Module& M : Result->modules()) {
+      ASSERT_EQ(M.getName(), "m" + std::to_string(I));
+      const Symbol& S = *M.symbol_begin();
+      EXPECT_EQ(S.getReferent<Block>(),
+                Node::getByUUID(InnerCtx, BlockIDs[(I + 1) % NumModules]));
+      EXPECT_EQ(S.getAddress(), Addr(0x1000 * ((I + 1) % NumModules)));
+
+      auto It = M.findSymbolicExpression(Addr(0x1000 * I));
+      ASSERT_NE(It, M.symbolic_expr_end());
+      const auto* SE = std::get_if<SymAddrConst>(&*It);
+      ASSERT_NE(SE, nullptr);
+      EXPECT_EQ(SE->Sym, Node::getByUUID(InnerCtx,
+                                         SymbolIDs[(I + NumModules - 1) %
+                                                   NumModules]));
+      ++I;
+    }
+  }
+}
+
+TEST(Unit_IR, compactNodeReferences) {
+  std::ostringstream UuidOut, IndexOut;
+  std::vector<UUID> BlockIDs, SymbolIDs;
+  const int NumBlocks = 16;
+
+  {
+    Context InnerCtx;
+    IR* Original = IR::Create(InnerCtx);
+    Module* M = Module::Create(InnerCtx, "m");
+    std::vector<Block*> Blocks;
+    std::vector<Symbol*> Symbols;
+    for (int I = 0; I < NumBlocks; ++I) {
+      Block* B = Block::Create(InnerCtx, Addr(0x1000 * I), 4);
+      Symbol* S = Symbol::Create(InnerCtx, B, "s" + std::to_string(I));
+      M->addBlock(B);
+      M->addSymbol(S);
+      Blocks.push_back(B);
+      Symbols.push_back(S);
+      BlockIDs.push_back(B->getUUID());
+      SymbolIDs.push_back(S->getUUID());
+    }
+    for (int I = 0; I < NumBlocks; ++I) {
+      addEdge(Blocks[I], Blocks[(I + 1) % NumBlocks], M->getCFG());
+      M->addSymbolicExpression(
+          Addr(0x1000 * I),
+          SymAddrAddr{1, 0, Symbols[I], Symbols[(I + 1) % NumBlocks]});
+    }
+    Original->addModule(M);
+    Original->save(UuidOut);
+    Original->save(IndexOut, NodeReferences::ByIndex);
+  }
+
+  EXPECT_LT(IndexOut.str().size(), UuidOut.str().size());
+
+  for (unsigned NumThreads : {1u, 4u}) {
+    Context InnerCtx;
+    std::istringstream In(IndexOut.str());
+    IR* Result = IR::load(InnerCtx, In, NumThreads);
+    ASSERT_NE(Result, nullptr);
+    const Module& M = *Result->begin();
+    EXPECT_EQ(num_vertices(M.getCFG()), static_cast<size_t>(NumBlocks));
+    EXPECT_EQ(num_edges(M.getCFG()), static_cast<size_t>(NumBlocks));
+
+    for (int I = 0; I < NumBlocks; ++I) {
+      const auto* B = dyn_cast<Block>(Node::getByUUID(InnerCtx, BlockIDs[I]));
+      const auto* Next = dyn_cast<Block>(
+          Node::getByUUID(InnerCtx, BlockIDs[(I + 1) % NumBlocks]));
+      ASSERT_NE(B, nullptr);
+      auto From = getVertex(B, M.getCFG());
+      auto To = getVertex(Next, M.getCFG());
+      ASSERT_TRUE(From && To);
+      EXPECT_TRUE(edge(*From, *To, M.getCFG()).second);
+
+      const auto* S =
+          dyn_cast<Symbol>(Node::getByUUID(InnerCtx, SymbolIDs[I]));
+      ASSERT_NE(S, nullptr);
+      EXPECT_EQ(S->getReferent<Block>(), B);
+
+      auto It = M.findSymbolicExpression(Addr(0x1000 * I));
+      ASSERT_NE(It, M.symbolic_expr_end());
+      const auto* SE = std::get_if<SymAddrAddr>(&*It);
+      ASSERT_NE(SE, nullptr);
+      EXPECT_EQ(SE->Sym1, S);
+      EXPECT_EQ(SE->Sym2, Node::getByUUID(InnerCtx,
+                                          SymbolIDs[(I + 1) % NumBlocks]));
+    }
+  }
+}
+
+TEST(Unit_IR, loadLazy) {
+  const std::string Path = "Unit_IR_loadLazy.gtirb";
+  std::vector<UUID> ModuleIDs;
+  std::string Indexed;
+
+  {
+    Context InnerCtx;
+    IR* Original = IR::Create(InnerCtx);
+    for (const char* Name : {"a", "b", "c"}) {
+      Module* M = Module::Create(InnerCtx, Name);
+      M->setISAID(ISAID::X64);
+      M->getImageByteMap().setAddrMinMax({Addr(0), Addr(0x100)});
+      M->getImageByteMap().setData(Addr(0x10), 4, std::byte(Name[0]));
+      M->addBlock(Block::Create(InnerCtx, Addr(0x10), 4));
+      Original->addModule(M);
+      ModuleIDs.push_back(M->getUUID());
+    }
+    Original->addAuxData("test", std::string("value"));
+
+    std::ofstream Out(Path, std::ios::binary);
+    Original->saveIndexed(Out);
+    std::ostringstream OutString;
+    Original->saveIndexed(OutString);
+    Indexed = OutString.str();
+  }
+
+  {
+    Context InnerCtx;
+    IR* Result = IR::loadLazy(InnerCtx, Path);
+    ASSERT_NE(Result, nullptr);
+    EXPECT_EQ(*Result->getAuxData("test")->get<std::string>(), "value");
+    for (const UUID& ID : ModuleIDs)
+      EXPECT_EQ(Node::getByUUID(InnerCtx, ID), nullptr);
+
+    // Looking up a module by name loads only that module.
+    auto Found = Result->findModules("b");
+    ASSERT_EQ(std::distance(Found.begin(), Found.end()), 1);
+    EXPECT_EQ(Found.begin()->getUUID(), ModuleIDs[1]);
+    EXPECT_EQ(Found.begin()->getISAID(), ISAID::X64);
+    EXPECT_EQ(Found.begin()->getImageByteMap().data(Addr(0x10), 1)[0],
+              std::byte('b'));
+    EXPECT_EQ(Node::getByUUID(InnerCtx, ModuleIDs[0]), nullptr);
+    EXPECT_NE(Node::getByUUID(InnerCtx, ModuleIDs[1]), nullptr);
+    EXPECT_EQ(Node::getByUUID(InnerCtx, ModuleIDs[2]), nullptr);
+    EXPECT_TRUE(Result->findModules("d").empty());
+
+    // Iterating loads the rest.
+    EXPECT_EQ(std::distance(Result->begin(), Result->end()), 3);
+    for (const UUID& ID : ModuleIDs)
+      EXPECT_NE(Node::getByUUID(InnerCtx, ID), nullptr);
+    EXPECT_TRUE(Result->loadModules());
+  }
+
+  // Adding a module loads the pending ones first.
+  {
+    Context InnerCtx;
+    IR* Result = IR::loadLazy(InnerCtx, Path);
+    ASSERT_NE(Result, nullptr);
+    Result->addModule(Module::Create(InnerCtx, "b"));
+    for (const UUID& ID : ModuleIDs)
+      EXPECT_NE(Node::getByUUID(InnerCtx, ID), nullptr);
+    EXPECT_EQ(std::distance(Result->findModules("b").begin(),
+                            Result->findModules("b").end()),
+              2);
+  }
+
+  // A module with a malformed payload is left out and reported.
+  {
+    std::string Corrupt = Indexed;
+    std::fill(Corrupt.end() - 8, Corrupt.end(), '\xff');
+    const std::string CorruptPath = "Unit_IR_loadLazy_corrupt.gtirb";
+    std::ofstream(CorruptPath, std::ios::binary) << Corrupt;
+
+    Context InnerCtx;
+    IR* Result = IR::loadLazy(InnerCtx, CorruptPath);
+    ASSERT_NE(Result, nullptr);
+    EXPECT_EQ(std::distance(Result->findModules("a").begin(),
+                            Result->findModules("a").end()),
+              1);
+    EXPECT_FALSE(Result->loadModules());
+    EXPECT_EQ(std::distance(Result->begin(), Result->end()), 2);
+    EXPECT_TRUE(Result->findModules("c").empty());
+    std::remove(CorruptPath.c_str());
+  }
+
+  // Serializing loads every module first.
+  {
+    Context InnerCtx;
+    IR* Result = IR::loadLazy(InnerCtx, Path);
+    ASSERT_NE(Result, nullptr);
+    std::ostringstream Json;
+    Result->saveJSON(Json);
+    for (const char* Name : {"\"a\"", "\"b\"", "\"c\""})
+      EXPECT_NE(Json.str().find(Name), std::string::npos);
+    for (const UUID& ID : ModuleIDs)
+      EXPECT_NE(Node::getByUUID(InnerCtx, ID), nullptr);
+  }
+
+  // The indexed format can also be loaded eagerly.
+  {
+    Context InnerCtx;
+    IR* Result = IR::loadMapped(InnerCtx, Path);
+    ASSERT_NE(Result, nullptr);
+    EXPECT_EQ(std::distance(Result->begin(), Result->end()), 3);
+    EXPECT_EQ(Result->begin()->getUUID(), ModuleIDs[0]);
+  }
+  {
+    Context InnerCtx;
+    std::istringstream In(Indexed);
+    IR* Result = IR::load(InnerCtx, In);
+    ASSERT_NE(Result, nullptr);
+    EXPECT_EQ(std::distance(Result->begin(), Result->end()), 3);
+    EXPECT_EQ(Result->getAuxDataSize(), 1);
+  }
+  std::remove(Path.c_str());
+}
+
+TEST(Unit_IR, loadLazyCrossModuleReferent) {
+  const std::string Path = "Unit_IR_loadLazyCrossModuleReferent.gtirb";
+  UUID SymID, BlockID;
+
+  {
+    Context InnerCtx;
+    IR* Original = IR::Create(InnerCtx);
+    Module* Referrer = Module::Create(InnerCtx, "a");
+    Module* Target = Module::Create(InnerCtx, "b");
+    auto* B = Block::Create(InnerCtx, Addr(0x10), 4);
+    Target->addBlock(B);
+    auto* S = Symbol::Create(InnerCtx, B, "sym");
+    Referrer->addSymbol(S);
+    Original->addModule(Referrer);
+    Original->addModule(Target);
+    SymID = S->getUUID();
+    BlockID = B->getUUID();
+
+    std::ofstream Out(Path, std::ios::binary);
+    Original->saveIndexed(Out);
+  }
+
+  // The referent is set once the module holding it is loaded.
+  {
+    Context InnerCtx;
+    IR* Result = IR::loadLazy(InnerCtx, Path);
+    ASSERT_NE(Result, nullptr);
+    auto Referrers = Result->findModules("a");
+    ASSERT_EQ(std::distance(Referrers.begin(), Referrers.end()), 1);
+    auto* S = dyn_cast_or_null<Symbol>(Node::getByUUID(InnerCtx, SymID));
+    ASSERT_NE(S, nullptr);
+    EXPECT_EQ(S->getReferent<Block>(), nullptr);
+
+    Result->findModules("b");
+    auto* B = dyn_cast_or_null<Block>(Node::getByUUID(InnerCtx, BlockID));
+    ASSERT_NE(B, nullptr);
+    EXPECT_EQ(S->getReferent<Block>(), B);
+    EXPECT_EQ(S->getAddress(), Addr(0x10));
+    auto Found = Referrers.begin()->findSymbols(*B);
+    ASSERT_EQ(std::distance(Found.begin(), Found.end()), 1);
+    EXPECT_EQ(&*Found.begin(), S);
+  }
+
+  // It also survives loading every module and saving again.
+  std::ostringstream Resaved;
+  {
+    Context InnerCtx;
+    IR* Result = IR::loadLazy(InnerCtx, Path);
+    ASSERT_NE(Result, nullptr);
+    EXPECT_EQ(std::distance(Result->begin(), Result->end()), 2);
+    auto* S = dyn_cast_or_null<Symbol>(Node::getByUUID(InnerCtx, SymID));
+    ASSERT_NE(S, nullptr);
+    ASSERT_NE(S->getReferent<Block>(), nullptr);
+    EXPECT_EQ(S->getReferent<Block>()->getUUID(), BlockID);
+    Result->save(Resaved);
+  }
+  {
+    Context InnerCtx;
+    std::istringstream In(Resaved.str());
+    IR* Result = IR::load(InnerCtx, In);
+    ASSERT_NE(Result, nullptr);
+    auto* S = dyn_cast_or_null<Symbol>(Node::getByUUID(InnerCtx, SymID));
+    ASSERT_NE(S, nullptr);
+    ASSERT_NE(S->getReferent<Block>(), nullptr);
+    EXPECT_EQ(S->getReferent<Block>()->getUUID(), BlockID);
+  }
+  std::remove(Path.c_str());
+}
+
 TEST(Unit_IR, move) {
   IR* Original = IR::Create(Ctx);
   EXPECT_TRUE(Original->getAuxDataEmpty());
@@ -0,0 +1,184 @@
+//===- IntervalIndex.test.cpp -----------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2018 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include <gtirb/Context.hpp>
+#include <gtirb/DataObject.hpp>
+#include <gtirb/IntervalIndex.hpp>
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <tuple>
+#include <vector>
+
+using namespace gtirb;
+
+static Context Ctx;
+
+using Index = IntervalIndex<DataObject>;
+
+static std::vector<DataObject*> toVector(Index::range R) {
+  return std::vector<DataObject*>(R.begin(), R.end());
+}
+
+// Find the objects overlapping [Lower, Upper) the slow way, in the order the
+// index returns them.
+static std::vector<DataObject*> overlapping(std::vector<DataObject*> Objects,
+                                            Addr Lower, Addr Upper) {
+  auto Misses = [Lower, Upper](const DataObject* D) {
+    return D->getAddress() >= Upper || addressLimit(*D) <= Lower;
+  };
+  Objects.erase(std::remove_if(Objects.begin(), Objects.end(), Misses),
+                Objects.end());
+  std::sort(Objects.begin(), Objects.end(),
+            [](const DataObject* A, const DataObject* B) {
+              return std::make_tuple(A->getAddress(), addressLimit(*A), A) <
+                     std::make_tuple(B->getAddress(), addressLimit(*B), B);
+            });
+  return Objects;
+}
+
+TEST(Unit_IntervalIndex, emptyIndex) {
+  Index I;
+  EXPECT_TRUE(I.empty());
+  EXPECT_TRUE(I.find(Addr(0)).empty());
+  EXPECT_TRUE(I.find(Addr(0), Addr(100)).empty());
+  EXPECT_FALSE(I.erase(DataObject::Create(Ctx, Addr(1), 1)));
+}
+
+TEST(Unit_IntervalIndex, find) {
+  Index I;
+  auto* D1 = DataObject::Create(Ctx, Addr(1), 20);
+  auto* D2 = DataObject::Create(Ctx, Addr(5), 10);
+  auto* D3 = DataObject::Create(Ctx, Addr(5), 0);
+  I.insert(D1);
+  I.insert(D2);
+  I.insert(D3);
+  EXPECT_EQ(I.size(), 3);
+
+  EXPECT_EQ(toVector(I.find(Addr(0))), std::vector<DataObject*>());
+  EXPECT_EQ(toVector(I.find(Addr(1))), std::vector<DataObject*>({D1}));
+  // Objects of size zero contain no address.
+  EXPECT_EQ(toVector(I.find(Addr(5))), std::vector<DataObject*>({D1, D2}));
+  EXPECT_EQ(toVector(I.find(Addr(15))), std::vector<DataObject*>({D1}));
+  EXPECT_EQ(toVector(I.find(Addr(21))), std::vector<DataObject*>());
+
+  EXPECT_EQ(toVector(I.find(Addr(0), Addr(2))),
+            std::vector<DataObject*>({D1}));
+  EXPECT_EQ(toVector(I.find(Addr(4), Addr(6))),
+            std::vector<DataObject*>({D1, D3, D2}));
+  EXPECT_EQ(toVector(I.find(Addr(21), Addr(30))), std::vector<DataObject*>());
+  EXPECT_EQ(toVector(I.find(Addr(6), Addr(6))), std::vector<DataObject*>());
+
+  EXPECT_TRUE(I.erase(D1));
+  EXPECT_FALSE(I.erase(D1));
+  EXPECT_EQ(toVector(I.find(Addr(5))), std::vector<DataObject*>({D2}));
+  EXPECT_EQ(I.size(), 2);
+}
+
+TEST(Unit_IntervalIndex, matchesLinearSearch) {
+  // Many heavily overlapping objects, as from overlapping decodes.
+  std::mt19937_64 Rng(0);
+  std::vector<DataObject*> Objects;
+  for (int N = 0; N < 2000; ++N)
+    Objects.push_back(DataObject::Create(Ctx, Addr(Rng() % 1000),
+                                         Rng() % 4 == 0 ? Rng() % 200
+                                                        : Rng() % 16));
+
+  Index Incremental;
+  for (auto* D : Objects)
+    Incremental.insert(D);
+  Index Bulk;
+  Bulk.insert(Objects.begin(), Objects.end());
+
+  auto Check = [&](const Index& I, const std::vector<DataObject*>& Expected) {
+    for (uint64_t A = 0; A < 1300; A += 7) {
+      EXPECT_EQ(toVector(I.find(Addr(A))),
+                overlapping(Expected, Addr(A), Addr(A + 1)));
+      EXPECT_EQ(toVector(I.find(Addr(A), Addr(A + 50))),
+                overlapping(Expected, Addr(A), Addr(A + 50)));
+    }
+  };
+  Check(Incremental, Objects);
+  Check(Bulk, Objects);
+  EXPECT_TRUE(Bulk.buildPageTable());
+  Check(Bulk, Objects);
+
+  // Erase most objects in random order, checking as the tree is rebuilt.
+  std::shuffle(Objects.begin(), Objects.end(), Rng);
+  while (Objects.size() > 300) {
+    for (int N = 0; N < 300; ++N) {
+      EXPECT_TRUE(Incremental.erase(Objects.back()));
+      Objects.pop_back();
+    }
+    Check(Incremental, Objects);
+  }
+  EXPECT_EQ(Incremental.size(), Objects.size());
+}
+
+TEST(Unit_IntervalIndex, smallBatches) {
+  // Batches small compared to the index are inserted one at a time, larger
+  // ones by rebuilding; both must give the same index.
+  std::mt19937_64 Rng(2);
+  std::vector<DataObject*> Objects;
+  Index I;
+  for (size_t Batch : {1000, 3, 1, 50, 200, 2000, 7}) {
+    std::vector<DataObject*> New;
+    for (size_t N = 0; N < Batch; ++N)
+      New.push_back(DataObject::Create(Ctx, Addr(Rng() % 5000), Rng() % 32));
+    I.insert(New.begin(), New.end());
+    Objects.insert(Objects.end(), New.begin(), New.end());
+    EXPECT_EQ(I.size(), Objects.size());
+    for (uint64_t A = 0; A < 5100; A += 13)
+      EXPECT_EQ(toVector(I.find(Addr(A), Addr(A + 20))),
+                overlapping(Objects, Addr(A), Addr(A + 20)));
+  }
+}
+
+TEST(Unit_IntervalIndex, pageTable) {
+  // Objects crossing pages and leaves of the table, in two distant regions.
+  std::mt19937_64 Rng(1);
+  std::vector<DataObject*> Objects;
+  for (int N = 0; N < 1000; ++N) {
+    uint64_t Base = N % 2 == 0 ? 0x3ff000 : 0x7fff0000;
+    Objects.push_back(DataObject::Create(
+        Ctx, Addr(Base + Rng() % 0x4000),
+        Rng() % 8 == 0 ? Rng() % 0x2000 : Rng() % 64));
+  }
+  Index I;
+  I.insert(Objects.begin(), Objects.end());
+  EXPECT_FALSE(I.hasPageTable());
+  ASSERT_TRUE(I.buildPageTable());
+  EXPECT_TRUE(I.hasPageTable());
+  for (uint64_t Base : {0x3fe000, 0x7ffef000}) {
+    for (uint64_t A = Base; A < Base + 0x7000; A += 13) {
+      EXPECT_EQ(toVector(I.find(Addr(A))),
+                overlapping(Objects, Addr(A), Addr(A + 1)));
+    }
+  }
+  EXPECT_TRUE(I.find(Addr(0)).empty());
+  EXPECT_TRUE(I.find(Addr(0x50000000)).empty());
+
+  // Changing the index discards the table.
+  auto* D = DataObject::Create(Ctx, Addr(0x1000), 4);
+  I.insert(D);
+  EXPECT_FALSE(I.hasPageTable());
+  EXPECT_EQ(toVector(I.find(Addr(0x1002))), std::vector<DataObject*>({D}));
+
+  // Objects spanning far more pages than there are objects are left to the
+  // tree.
+  Index Huge;
+  Huge.insert(DataObject::Create(Ctx, Addr(0), uint64_t(1) << 40));
+  EXPECT_FALSE(Huge.buildPageTable());
+  EXPECT_EQ(toVector(Huge.find(Addr(12345))).size(), 1);
+}
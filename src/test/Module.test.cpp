@@ -25,6 +25,7 @@
 #include <algorithm>
 #include <gtest/gtest.h>
 #include <iterator>
+#include <random>
 #include <tuple>
 #include <utility>
 
@@ -137,6 +138,24 @@ TEST(Unit_Module, compilationIteratorTypes) {
 
 static Context Ctx;
 
+// The symbols in a range, in pointer order, for comparisons which do not
+// depend on the order the range is in.
+template <typename RangeTy>
+static std::vector<const Symbol*> symbolSet(const RangeTy& R) {
+  std::vector<const Symbol*> Result;
+  for (const Symbol& S : R)
+    Result.push_back(&S);
+  std::sort(Result.begin(), Result.end());
+  return Result;
+}
+
+static std::vector<const Symbol*> symbolSet(const Symbol* A,
+                                            const Symbol* B) {
+  std::vector<const Symbol*> Result{A, B};
+  std::sort(Result.begin(), Result.end());
+  return Result;
+}
+
 TEST(Unit_Module, ctor_0) { EXPECT_NE(Module::Create(Ctx), nullptr); }
 
 TEST(Unit_Module, setBinaryPath) {
@@ -303,6 +322,43 @@ TEST(Unit_Module, findSection) {
   }
 }
 
+TEST(Unit_Module, eraseSection) {
+  Context C;
+  auto* M = Module::Create(C);
+  auto* S1 = Section::Create(C, "a", Addr(1), 20);
+  auto* S2 = Section::Create(C, "b", Addr(5), 10);
+  M->addSection({S1, S2});
+
+  M->eraseSection(S1);
+  EXPECT_EQ(std::distance(M->section_begin(), M->section_end()), 1);
+  EXPECT_EQ(M->findSection("a"), M->section_by_name_end());
+  EXPECT_EQ(std::distance(M->findSection(Addr(1)).begin(),
+                          M->findSection(Addr(1)).end()),
+            0);
+  auto F = M->findSection(Addr(5));
+  ASSERT_EQ(std::distance(F.begin(), F.end()), 1);
+  EXPECT_EQ(&*F.begin(), S2);
+  EXPECT_EQ(C.getMemoryStats().Sections.LiveCount, 1);
+}
+
+TEST(Unit_Module, indexMemory) {
+  Context C;
+  auto* M = Module::Create(C);
+  size_t Before = C.getMemoryStats().IndexBytes;
+  for (uint64_t I = 0; I < 1000; ++I) {
+    emplaceBlock(*M, C, Addr(I), 1);
+    emplaceSymbol(*M, C, Addr(I), "s");
+  }
+  // The module's containers draw their memory from the Context.
+  EXPECT_GT(C.getMemoryStats().IndexBytes, Before);
+  EXPECT_EQ(std::distance(M->findSymbols("s").begin(),
+                          M->findSymbols("s").end()),
+            1000);
+
+  C.reset(0);
+  EXPECT_EQ(C.getMemoryStats().IndexBytes, 0);
+}
+
 TEST(Unit_Module, blocks) {
   auto M = Module::Create(Ctx);
   auto* B = emplaceBlock(*M, Ctx, Addr(1), 10);
@@ -393,6 +449,415 @@ TEST(Unit_Module, findBlock) {
   }
 }
 
+TEST(Unit_Module, findOverlapping) {
+  auto* M = Module::Create(Ctx);
+  auto* B1 = emplaceBlock(*M, Ctx, Addr(0), 4);
+  auto* B2 = emplaceBlock(*M, Ctx, Addr(2), 10);
+  auto* B3 = emplaceBlock(*M, Ctx, Addr(12), 4);
+  emplaceBlock(*M, Ctx, Addr(0x10000), 4);
+
+  auto F = M->findBlocks(Addr(3), Addr(13));
+  ASSERT_EQ(std::distance(F.begin(), F.end()), 3);
+  auto It = F.begin();
+  EXPECT_EQ(&*It++, B1);
+  EXPECT_EQ(&*It++, B2);
+  EXPECT_EQ(&*It++, B3);
+  F = M->findBlocks(Addr(4), Addr(12));
+  ASSERT_EQ(std::distance(F.begin(), F.end()), 1);
+  EXPECT_EQ(&*F.begin(), B2);
+  F = M->findBlocks(Addr(16), Addr(0x10000));
+  EXPECT_EQ(F.begin(), F.end());
+  F = M->findBlocks(Addr(8), Addr(8));
+  EXPECT_EQ(F.begin(), F.end());
+
+  auto* D = DataObject::Create(Ctx, Addr(8), 8);
+  M->addData(D);
+  const Module& CM = *M;
+  auto FD = CM.findData(Addr(0), Addr(9));
+  ASSERT_EQ(std::distance(FD.begin(), FD.end()), 1);
+  EXPECT_EQ(&*FD.begin(), D);
+  FD = CM.findData(Addr(16), Addr(20));
+  EXPECT_EQ(FD.begin(), FD.end());
+
+  auto* S1 = Section::Create(Ctx, "a", Addr(0), 0x1000);
+  auto* S2 = Section::Create(Ctx, "b", Addr(0x1000), 0x1000);
+  M->addSection({S1, S2});
+  auto FS = M->findSections(Addr(0xfff), Addr(0x1001));
+  ASSERT_EQ(std::distance(FS.begin(), FS.end()), 2);
+  EXPECT_EQ(&*FS.begin(), S1);
+  FS = M->findSections(Addr(0x1000), Addr(0x2000));
+  ASSERT_EQ(std::distance(FS.begin(), FS.end()), 1);
+  EXPECT_EQ(&*FS.begin(), S2);
+}
+
+TEST(Unit_Module, pageTables) {
+  auto* M = Module::Create(Ctx);
+  auto* B1 = emplaceBlock(*M, Ctx, Addr(0x1000), 0x1800);
+  auto* B2 = emplaceBlock(*M, Ctx, Addr(0x2000), 0x10);
+  auto* S = Section::Create(Ctx, "s", Addr(0x1000), 0x2000);
+  M->addSection(S);
+  M->buildPageTables();
+
+  auto F = M->findBlock(Addr(0x2008));
+  ASSERT_EQ(std::distance(F.begin(), F.end()), 2);
+  EXPECT_EQ(&*F.begin(), B1);
+  EXPECT_EQ(&*std::next(F.begin()), B2);
+  F = M->findBlock(Addr(0x2800));
+  EXPECT_EQ(F.begin(), F.end());
+  auto FS = M->findSection(Addr(0x2fff));
+  ASSERT_EQ(std::distance(FS.begin(), FS.end()), 1);
+  EXPECT_EQ(&*FS.begin(), S);
+
+  // Moving a block updates the index as usual.
+  setAddress(*M, *B2, Addr(0x2800));
+  F = M->findBlock(Addr(0x2808));
+  ASSERT_EQ(std::distance(F.begin(), F.end()), 1);
+  EXPECT_EQ(&*F.begin(), B2);
+
+  M->addSymbolicExpression(Addr(0x2000), SymAddrConst{});
+  EXPECT_NE(M->findSymbolicExpression(Addr(0x2000)), M->symbolic_expr_end());
+  EXPECT_EQ(M->findSymbolicExpression(Addr(0x2001)), M->symbolic_expr_end());
+}
+
+TEST(Unit_Module, findSorted) {
+  Context C;
+  auto* M = Module::Create(C);
+  std::mt19937_64 Rng(0);
+  for (int N = 0; N < 2000; ++N) {
+    emplaceBlock(*M, C, Addr(Rng() % 20000), Rng() % 32);
+    auto* D = DataObject::Create(C, Addr(Rng() % 20000), Rng() % 8);
+    M->addData(D);
+    emplaceSymbol(*M, C, Addr(Rng() % 20000), "s");
+  }
+
+  std::vector<Addr> Sorted;
+  for (int N = 0; N < 10000; ++N)
+    Sorted.push_back(Addr(Rng() % 21000));
+  std::sort(Sorted.begin(), Sorted.end());
+
+  // Compare with looking up each address separately, with and without
+  // threads, walking the indexes and searching them.
+  auto Few = std::vector<Addr>(Sorted.begin(), Sorted.begin() + 20);
+  for (const auto* Xs : {&Sorted, &Few}) {
+    for (unsigned Threads : {1, 4}) {
+      auto Blocks = M->findBlocks(*Xs, Threads);
+      auto Data = static_cast<const Module*>(M)->findData(*Xs, Threads);
+      auto Syms = M->findSymbols(*Xs, Threads);
+      ASSERT_EQ(Blocks.size(), Xs->size());
+      ASSERT_EQ(Data.size(), Xs->size());
+      ASSERT_EQ(Syms.size(), Xs->size());
+      for (size_t I = 0; I < Xs->size(); ++I) {
+        auto B = M->findBlock((*Xs)[I]);
+        EXPECT_TRUE(std::equal(Blocks[I].begin(), Blocks[I].end(), B.begin(),
+                               B.end(), [](const Block& L, const Block& R) {
+                                 return &L == &R;
+                               }));
+        auto D = M->findData((*Xs)[I]);
+        EXPECT_TRUE(std::equal(Data[I].begin(), Data[I].end(), D.begin(),
+                               D.end(),
+                               [](const DataObject& L, const DataObject& R) {
+                                 return &L == &R;
+                               }));
+        auto S = M->findSymbols((*Xs)[I]);
+        EXPECT_EQ(std::distance(Syms[I].begin(), Syms[I].end()),
+                  std::distance(S.begin(), S.end()));
+        EXPECT_TRUE(std::all_of(
+            Syms[I].begin(), Syms[I].end(),
+            [&](const Symbol& Sym) { return Sym.getAddress() == (*Xs)[I]; }));
+      }
+    }
+  }
+  EXPECT_TRUE(M->findBlocks(std::vector<Addr>()).empty());
+}
+
+TEST(Unit_Module, addRanges) {
+  auto* M = Module::Create(Ctx);
+  auto* B1 = emplaceBlock(*M, Ctx, Addr(4), 2);
+  std::vector<Block*> Bs{Block::Create(Ctx, Addr(8), 4),
+                         Block::Create(Ctx, Addr(0), 6), B1};
+  Bs.push_back(Bs[0]); // duplicates are ignored
+  M->addBlocks(Bs.begin(), Bs.end());
+  EXPECT_EQ(std::distance(M->block_begin(), M->block_end()), 3);
+  EXPECT_EQ(num_vertices(M->getCFG()), 3);
+  auto It = M->block_begin();
+  EXPECT_EQ(&*It++, Bs[1]);
+  EXPECT_EQ(&*It++, B1);
+  EXPECT_EQ(&*It++, Bs[0]);
+  auto F = M->findBlock(Addr(5));
+  EXPECT_EQ(std::distance(F.begin(), F.end()), 2);
+
+  std::vector<DataObject*> Ds{DataObject::Create(Ctx, Addr(0), 4),
+                              DataObject::Create(Ctx, Addr(2), 4)};
+  M->addData(Ds.begin(), Ds.end());
+  EXPECT_EQ(std::distance(M->data_begin(), M->data_end()), 2);
+  auto FD = M->findData(Addr(3));
+  EXPECT_EQ(std::distance(FD.begin(), FD.end()), 2);
+
+  std::vector<Section*> Ss{Section::Create(Ctx, "a", Addr(0), 4),
+                           Section::Create(Ctx, "b", Addr(4), 4)};
+  M->addSection(Ss.begin(), Ss.end());
+  EXPECT_EQ(M->findSection("b")->getAddress(), Addr(4));
+  auto FS = M->findSection(Addr(5));
+  EXPECT_EQ(std::distance(FS.begin(), FS.end()), 1);
+
+  std::vector<ProxyBlock*> Ps{ProxyBlock::Create(Ctx),
+                              ProxyBlock::Create(Ctx)};
+  M->addProxyBlocks(Ps.begin(), Ps.end());
+  EXPECT_EQ(num_vertices(M->getCFG()), 5);
+}
+
+TEST(Unit_Module, eraseBlock) {
+  Context C;
+  auto* M = Module::Create(C);
+  auto* B1 = emplaceBlock(*M, C, Addr(1), 20);
+  auto* B2 = emplaceBlock(*M, C, Addr(5), 10);
+  auto* B3 = emplaceBlock(*M, C, Addr(30), 10);
+  addEdge(B1, B2, M->getCFG());
+  addEdge(B2, B3, M->getCFG());
+  addEdge(B3, B1, M->getCFG());
+  UUID Id = B2->getUUID();
+
+  M->eraseBlock(B2);
+  EXPECT_EQ(std::distance(M->block_begin(), M->block_end()), 2);
+  EXPECT_EQ(Node::getByUUID(C, Id), nullptr);
+
+  auto F = M->findBlock(Addr(5));
+  ASSERT_EQ(std::distance(F.begin(), F.end()), 1);
+  EXPECT_EQ(&*F.begin(), B1);
+
+  // Only the edge between the remaining blocks is left.
+  const CFG& Cfg = M->getCFG();
+  EXPECT_EQ(num_vertices(Cfg), 2);
+  ASSERT_EQ(num_edges(Cfg), 1);
+  auto E = *edges(Cfg).first;
+  EXPECT_EQ(Cfg[source(E, Cfg)], B3);
+  EXPECT_EQ(Cfg[target(E, Cfg)], B1);
+  EXPECT_TRUE(addEdge(B1, B3, M->getCFG()));
+
+  // The next block takes the erased block's place.
+  auto Stats = C.getMemoryStats();
+  EXPECT_EQ(Stats.Blocks.LiveCount, 2);
+  EXPECT_EQ(Block::Create(C, Addr(5), 10), B2);
+  EXPECT_EQ(C.getMemoryStats().Blocks.SlabBytes, Stats.Blocks.SlabBytes);
+}
+
+TEST(Unit_Module, removeNodes) {
+  auto* M = Module::Create(Ctx);
+  auto* B1 = emplaceBlock(*M, Ctx, Addr(1), 20);
+  auto* B2 = emplaceBlock(*M, Ctx, Addr(5), 10);
+  auto* P = ProxyBlock::Create(Ctx);
+  M->addProxyBlock(P);
+  addEdge(B1, B2, M->getCFG());
+  addEdge(B2, P, M->getCFG());
+  auto* D = DataObject::Create(Ctx, Addr(2), 4);
+  M->addData(D);
+  auto* S = Section::Create(Ctx, "s", Addr(0), 40);
+  M->addSection(S);
+  auto* Sym = emplaceSymbol(*M, Ctx, Addr(1), "sym");
+  M->addSymbolicExpression(Addr(3), SymAddrConst{0, Sym});
+  auto* BlockSym = emplaceSymbol(*M, Ctx, B1, "block");
+
+  EXPECT_TRUE(M->removeBlock(B1));
+  EXPECT_FALSE(M->removeBlock(B1));
+  EXPECT_EQ(std::distance(M->block_begin(), M->block_end()), 1);
+  auto F = M->findBlock(Addr(5));
+  ASSERT_EQ(std::distance(F.begin(), F.end()), 1);
+  EXPECT_EQ(&*F.begin(), B2);
+  EXPECT_EQ(num_vertices(M->getCFG()), 2);
+  EXPECT_EQ(num_edges(M->getCFG()), 1);
+  EXPECT_FALSE(getVertex(B1, M->getCFG()));
+  // Symbols no longer refer to a removed block, but keep its address.
+  EXPECT_TRUE(M->findSymbols(*B1).empty());
+  EXPECT_FALSE(BlockSym->hasReferent());
+  EXPECT_EQ(BlockSym->getAddress(), Addr(1));
+
+  EXPECT_TRUE(M->removeProxyBlock(P));
+  EXPECT_EQ(num_edges(M->getCFG()), 0);
+
+  EXPECT_TRUE(M->removeData(D));
+  EXPECT_FALSE(M->removeData(D));
+  EXPECT_EQ(M->data_begin(), M->data_end());
+  auto FD = M->findData(Addr(3));
+  EXPECT_EQ(FD.begin(), FD.end());
+
+  EXPECT_TRUE(M->removeSection(S));
+  EXPECT_EQ(M->findSection("s"), M->section_by_name_end());
+  auto FS = M->findSection(Addr(3));
+  EXPECT_EQ(FS.begin(), FS.end());
+
+  EXPECT_TRUE(M->removeSymbolicExpression(Addr(3)));
+  EXPECT_FALSE(M->removeSymbolicExpression(Addr(3)));
+  EXPECT_EQ(M->findSymbolicExpression(Addr(3)), M->symbolic_expr_end());
+
+  M->addSymbolicExpression(Addr(7), SymStackConst{0, Sym});
+  EXPECT_TRUE(M->removeSymbol(Sym));
+  EXPECT_TRUE(M->findSymbols("sym").empty());
+  // Symbolic expressions naming a removed symbol stay, so the symbol can be
+  // added back; only erasing it drops them.
+  EXPECT_NE(M->findSymbolicExpression(Addr(7)), M->symbolic_expr_end());
+  auto Addrs = M->getSymbolicExpressionAddrs(*Sym);
+  EXPECT_EQ(std::vector<Addr>(Addrs.begin(), Addrs.end()),
+            std::vector<Addr>{Addr(7)});
+  M->addSymbol(Sym);
+  M->eraseSymbol(Sym);
+  EXPECT_EQ(M->findSymbolicExpression(Addr(7)), M->symbolic_expr_end());
+
+  // Removed nodes are still alive and can be added again.
+  M->addBlock(B1);
+  M->addData(D);
+  EXPECT_EQ(std::distance(M->block_begin(), M->block_end()), 2);
+  EXPECT_EQ(&*M->data_begin(), D);
+}
+
+TEST(Unit_Module, eraseDetachesReferences) {
+  auto* M = Module::Create(Ctx);
+  auto* B = emplaceBlock(*M, Ctx, Addr(1), 4);
+  auto* D = DataObject::Create(Ctx, Addr(8), 4);
+  M->addData(D);
+  auto* P = ProxyBlock::Create(Ctx);
+  M->addProxyBlock(P);
+  auto* S1 = emplaceSymbol(*M, Ctx, B, "s1");
+  auto* S2 = emplaceSymbol(*M, Ctx, D, "s2");
+  auto* S3 = emplaceSymbol(*M, Ctx, P, "s3");
+
+  // Symbols referring to erased nodes keep their address.
+  M->eraseBlock(B);
+  M->eraseData(D);
+  M->eraseProxyBlock(P);
+  EXPECT_FALSE(S1->hasReferent());
+  EXPECT_EQ(S1->getAddress(), Addr(1));
+  EXPECT_FALSE(S2->hasReferent());
+  EXPECT_EQ(S2->getAddress(), Addr(8));
+  EXPECT_FALSE(S3->hasReferent());
+  EXPECT_FALSE(S3->getAddress());
+  {
+    auto F = M->findSymbols(Addr(8));
+    ASSERT_EQ(std::distance(F.begin(), F.end()), 1);
+    EXPECT_EQ(&*F.begin(), S2);
+  }
+
+  // Symbolic expressions naming an erased symbol are removed.
+  M->addSymbolicExpression(Addr(20), SymAddrConst{0, S1});
+  M->addSymbolicExpression(Addr(24), SymAddrAddr{1, 0, S2, S1});
+  M->addSymbolicExpression(Addr(28), SymAddrConst{0, S2});
+  M->eraseSymbol(S1);
+  EXPECT_EQ(M->findSymbolicExpression(Addr(20)), M->symbolic_expr_end());
+  EXPECT_EQ(M->findSymbolicExpression(Addr(24)), M->symbolic_expr_end());
+  EXPECT_NE(M->findSymbolicExpression(Addr(28)), M->symbolic_expr_end());
+  auto R = M->getSymbolicExpressionAddrs(*S2);
+  EXPECT_EQ(std::vector<Addr>(R.begin(), R.end()),
+            std::vector<Addr>({Addr(28)}));
+}
+
+TEST(Unit_Module, setBlockExtent) {
+  auto* M = Module::Create(Ctx);
+  auto* B1 = emplaceBlock(*M, Ctx, Addr(1), 4);
+  auto* B2 = emplaceBlock(*M, Ctx, Addr(8), 4);
+
+  setAddress(*M, *B1, Addr(20));
+  EXPECT_EQ(B1->getAddress(), Addr(20));
+  EXPECT_EQ(&*M->block_begin(), B2);
+  auto F = M->findBlock(Addr(2));
+  EXPECT_EQ(F.begin(), F.end());
+  F = M->findBlock(Addr(21));
+  ASSERT_EQ(std::distance(F.begin(), F.end()), 1);
+  EXPECT_EQ(&*F.begin(), B1);
+
+  setSize(*M, *B2, 20);
+  EXPECT_EQ(B2->getSize(), 20);
+  F = M->findBlock(Addr(21));
+  EXPECT_EQ(std::distance(F.begin(), F.end()), 2);
+
+  // Blocks outside the module just change.
+  auto* B3 = Block::Create(Ctx, Addr(1), 4);
+  setAddress(*M, *B3, Addr(2));
+  EXPECT_EQ(B3->getAddress(), Addr(2));
+  EXPECT_EQ(std::distance(M->block_begin(), M->block_end()), 2);
+}
+
+TEST(Unit_Module, setDataAndSectionExtent) {
+  auto* M = Module::Create(Ctx);
+  auto* D = DataObject::Create(Ctx, Addr(1), 4);
+  M->addData(D);
+  auto* S = Section::Create(Ctx, "s", Addr(0), 8);
+  M->addSection(S);
+
+  setAddress(*M, *D, Addr(10));
+  setSize(*M, *D, 2);
+  auto FD = M->findData(Addr(2));
+  EXPECT_EQ(FD.begin(), FD.end());
+  FD = M->findData(Addr(11));
+  ASSERT_EQ(std::distance(FD.begin(), FD.end()), 1);
+  EXPECT_EQ(&*FD.begin(), D);
+  FD = M->findData(Addr(12));
+  EXPECT_EQ(FD.begin(), FD.end());
+
+  setSize(*M, *S, 16);
+  setAddress(*M, *S, Addr(4));
+  auto FS = M->findSection(Addr(2));
+  EXPECT_EQ(FS.begin(), FS.end());
+  FS = M->findSection(Addr(19));
+  ASSERT_EQ(std::distance(FS.begin(), FS.end()), 1);
+  EXPECT_EQ(&*FS.begin(), S);
+  EXPECT_EQ(M->findSection("s")->getAddress(), Addr(4));
+}
+
+TEST(Unit_Module, setAddressMovesSymbols) {
+  auto* M = Module::Create(Ctx);
+  auto* B1 = emplaceBlock(*M, Ctx, Addr(1), 4);
+  auto* B2 = emplaceBlock(*M, Ctx, Addr(50), 4);
+  auto* D = DataObject::Create(Ctx, Addr(60), 4);
+  M->addData(D);
+  auto* S1 = emplaceSymbol(*M, Ctx, B1, "s1");
+  auto* S2 = emplaceSymbol(*M, Ctx, B2, "s2");
+  auto* S3 = emplaceSymbol(*M, Ctx, D, "s3");
+
+  setAddress(*M, *B1, Addr(100));
+  EXPECT_TRUE(M->findSymbols(Addr(1)).empty());
+  {
+    auto F = M->findSymbols(Addr(100));
+    ASSERT_EQ(std::distance(F.begin(), F.end()), 1);
+    EXPECT_EQ(&*F.begin(), S1);
+  }
+  {
+    auto F = M->findSymbols(Addr(50));
+    ASSERT_EQ(std::distance(F.begin(), F.end()), 1);
+    EXPECT_EQ(&*F.begin(), S2);
+  }
+
+  setAddress(*M, *D, Addr(10));
+  {
+    auto F = M->findSymbols(Addr(10));
+    ASSERT_EQ(std::distance(F.begin(), F.end()), 1);
+    EXPECT_EQ(&*F.begin(), S3);
+  }
+
+  // Symbols are still in address order, and keep their referents.
+  std::vector<const Symbol*> Order;
+  for (const Symbol& S : M->findSymbols(Addr(0), Addr(1000)))
+    Order.push_back(&S);
+  EXPECT_EQ(Order, std::vector<const Symbol*>({S3, S2, S1}));
+  {
+    auto F = M->findSymbols(*B1);
+    ASSERT_EQ(std::distance(F.begin(), F.end()), 1);
+    EXPECT_EQ(&*F.begin(), S1);
+  }
+}
+
+TEST(Unit_Module, eraseProxyBlock) {
+  Context C;
+  auto* M = Module::Create(C);
+  auto* B = emplaceBlock(*M, C, Addr(1), 20);
+  auto* P = ProxyBlock::Create(C);
+  M->addProxyBlock(P);
+  addEdge(B, P, M->getCFG());
+
+  M->eraseProxyBlock(P);
+  EXPECT_EQ(num_vertices(M->getCFG()), 1);
+  EXPECT_EQ(num_edges(M->getCFG()), 0);
+  EXPECT_EQ(C.getMemoryStats().ProxyBlocks.LiveCount, 0);
+}
+
 TEST(Unit_Module, dataObjects) {
   auto* M = Module::Create(Ctx);
   M->addData(DataObject::Create(Ctx, Addr(1), 123));
@@ -461,6 +926,27 @@ TEST(Unit_Module, findData) {
   }
 }
 
+TEST(Unit_Module, eraseData) {
+  Context C;
+  auto* M = Module::Create(C);
+  auto* D1 = DataObject::Create(C, Addr(1), 20);
+  auto* D2 = DataObject::Create(C, Addr(5), 10);
+  M->addData({D1, D2});
+  UUID Id = D2->getUUID();
+
+  M->eraseData(D2);
+  EXPECT_EQ(std::distance(M->data_begin(), M->data_end()), 1);
+  EXPECT_EQ(Node::getByUUID(C, Id), nullptr);
+  auto F = M->findData(Addr(5));
+  ASSERT_EQ(std::distance(F.begin(), F.end()), 1);
+  EXPECT_EQ(&*F.begin(), D1);
+
+  // Erasing a data object which is not in the module does nothing.
+  auto* D3 = DataObject::Create(C, Addr(1), 20);
+  M->eraseData(D3);
+  EXPECT_EQ(Node::getByUUID(C, D3->getUUID()), D3);
+}
+
 TEST(Unit_Module, symbolIterationOrder) {
   auto* M = Module::Create(Ctx);
   auto* S1 = emplaceSymbol(*M, Ctx, Addr(3), "foo");
@@ -543,6 +1029,22 @@ TEST(Unit_Module, findSymbols) {
   }
 }
 
+TEST(Unit_Module, eraseSymbol) {
+  Context C;
+  auto* M = Module::Create(C);
+  auto* S1 = emplaceSymbol(*M, C, Addr(1), "foo");
+  auto* S2 = emplaceSymbol(*M, C, Addr(1), "foo");
+
+  M->eraseSymbol(S1);
+  auto Found = M->findSymbols("foo");
+  ASSERT_EQ(std::distance(Found.begin(), Found.end()), 1);
+  EXPECT_EQ(&*Found.begin(), S2);
+  auto AtAddr = M->findSymbols(Addr(1));
+  ASSERT_EQ(std::distance(AtAddr.begin(), AtAddr.end()), 1);
+  EXPECT_EQ(&*AtAddr.begin(), S2);
+  EXPECT_EQ(Symbol::Create(C, Addr(2), "bar"), S1);
+}
+
 TEST(Unit_Module, symbolWithoutAddr) {
   auto* M = Module::Create(Ctx);
   emplaceSymbol(*M, Ctx, "test");
@@ -665,6 +1167,45 @@ TEST(Unit_Module, setSymbolAddress) {
   }
 }
 
+TEST(Unit_Module, findSymbolsByReferent) {
+  auto* M = Module::Create(Ctx);
+  auto* B1 = emplaceBlock(*M, Ctx, Addr(1), 1);
+  auto* B2 = emplaceBlock(*M, Ctx, Addr(2), 1);
+  auto* D = DataObject::Create(Ctx, Addr(3), 1);
+  M->addData(D);
+  auto* S1 = emplaceSymbol(*M, Ctx, B1, "foo");
+  auto* S2 = emplaceSymbol(*M, Ctx, B1, "bar");
+  auto* S3 = emplaceSymbol(*M, Ctx, D, "baz");
+  emplaceSymbol(*M, Ctx, Addr(1), "qux");
+
+  EXPECT_EQ(symbolSet(M->findSymbols(*B1)), symbolSet(S1, S2));
+  EXPECT_TRUE(M->findSymbols(*B2).empty());
+  {
+    auto F = M->findSymbols(*D);
+    EXPECT_EQ(std::distance(F.begin(), F.end()), 1);
+    EXPECT_EQ(&*F.begin(), S3);
+  }
+
+  // The index follows changes to the referent.
+  setReferent(*M, *S2, B2);
+  setSymbolAddress(*M, *S3, Addr(3));
+  {
+    auto F = M->findSymbols(*B1);
+    EXPECT_EQ(std::distance(F.begin(), F.end()), 1);
+    EXPECT_EQ(&*F.begin(), S1);
+  }
+  {
+    const Module& CM = *M;
+    auto F = CM.findSymbols(*B2);
+    EXPECT_EQ(std::distance(F.begin(), F.end()), 1);
+    EXPECT_EQ(&*F.begin(), S2);
+  }
+  EXPECT_TRUE(M->findSymbols(*D).empty());
+
+  M->removeSymbol(S1);
+  EXPECT_TRUE(M->findSymbols(*B1).empty());
+}
+
 TEST(Unit_Module, symbolicExpressions) {
   auto* M = Module::Create(Ctx);
   Symbol* S = Symbol::Create(Ctx);
@@ -767,6 +1308,46 @@ TEST(Unit_Module, getAddrsForSymbolicExpression) {
   }
 }
 
+TEST(Unit_Module, getSymbolicExpressionAddrs) {
+  auto* M = Module::Create(Ctx);
+  auto* S1 = Symbol::Create(Ctx, Addr(1), "foo");
+  auto* S2 = Symbol::Create(Ctx, Addr(2), "bar");
+  auto* S3 = Symbol::Create(Ctx, Addr(3), "baz");
+  auto Addrs = [&M](const Symbol* S) {
+    auto R = M->getSymbolicExpressionAddrs(*S);
+    return std::vector<Addr>(R.begin(), R.end());
+  };
+
+  M->addSymbolicExpression(Addr(30), SymAddrConst{0, S1});
+  M->addSymbolicExpression(Addr(10), SymStackConst{0, S1});
+  M->addSymbolicExpression(Addr(20), SymAddrAddr{1, 0, S1, S2});
+  M->addSymbolicExpression(Addr(40), SymAddrAddr{1, 0, S2, S2});
+  EXPECT_EQ(Addrs(S1), std::vector<Addr>({Addr(10), Addr(20), Addr(30)}));
+  EXPECT_EQ(Addrs(S2), std::vector<Addr>({Addr(20), Addr(40)}));
+  EXPECT_EQ(Addrs(S3), std::vector<Addr>());
+
+  // Replacing an expression drops the symbols it no longer mentions.
+  M->addSymbolicExpression(Addr(20), SymAddrConst{0, S3});
+  EXPECT_EQ(Addrs(S1), std::vector<Addr>({Addr(10), Addr(30)}));
+  EXPECT_EQ(Addrs(S2), std::vector<Addr>({Addr(40)}));
+  EXPECT_EQ(Addrs(S3), std::vector<Addr>({Addr(20)}));
+
+  EXPECT_TRUE(M->removeSymbolicExpression(Addr(40)));
+  EXPECT_FALSE(M->removeSymbolicExpression(Addr(40)));
+  EXPECT_EQ(Addrs(S2), std::vector<Addr>());
+
+  // The index is rebuilt when deserializing.
+  proto::Module Message;
+  M->addSymbol(S1);
+  M->toProtobuf(&Message);
+  Context InnerCtx;
+  Module* Result = Module::fromProtobuf(InnerCtx, Message);
+  const Symbol& Loaded = *Result->findSymbols("foo").begin();
+  auto R = Result->getSymbolicExpressionAddrs(Loaded);
+  EXPECT_EQ(std::vector<Addr>(R.begin(), R.end()),
+            std::vector<Addr>({Addr(10), Addr(30)}));
+}
+
 TEST(Unit_Module, protobufRoundTrip) {
   proto::Module Message;
 
@@ -814,11 +1395,11 @@ TEST(Unit_Module, protobufRoundTrip) {
   EXPECT_EQ(std::distance(Result->symbol_begin(), Result->symbol_end()), 3);
   {
     auto Found = Result->findSymbols("name1");
-    EXPECT_EQ(distance(Found.begin(), Found.end()), 2);
+    EXPECT_EQ(std::distance(Found.begin(), Found.end()), 2);
   }
   {
     auto Found = Result->findSymbols(Addr(1));
-    EXPECT_EQ(distance(Found.begin(), Found.end()), 2);
+    EXPECT_EQ(std::distance(Found.begin(), Found.end()), 2);
   }
 
   // Make sure various collections and node members are serialized, but
@@ -14,8 +14,11 @@
 //===----------------------------------------------------------------------===//
 #include <gtirb/Context.hpp>
 #include <gtirb/Node.hpp>
+#include <gtirb/Block.hpp>
+#include <gtirb/Symbol.hpp>
 #include <fstream>
 #include <gtest/gtest.h>
+#include <thread>
 
 static gtirb::Context Ctx;
 
@@ -54,3 +57,216 @@ TEST(Unit_Node, getByUUID) {
   const gtirb::Context& ConstCtx = Ctx;
   EXPECT_EQ(gtirb::Node::getByUUID(ConstCtx, N->getUUID()), N);
 }
+
+TEST(Unit_Node, randomUuidsAreVersion4) {
+  const auto* N = gtirb::Node::Create(Ctx);
+  EXPECT_EQ(N->getUUID().version(), gtirb::UUID::version_random_number_based);
+  EXPECT_EQ(N->getUUID().variant(), gtirb::UUID::variant_rfc_4122);
+}
+
+TEST(Unit_Node, seededUuidsAreReproducible) {
+  std::vector<gtirb::UUID> First, Second;
+  for (auto* Uuids : {&First, &Second}) {
+    gtirb::Context InnerCtx;
+    InnerCtx.useRandomUUIDs(42);
+    for (size_t I = 0; I < 16; ++I)
+      Uuids->push_back(gtirb::Node::Create(InnerCtx)->getUUID());
+  }
+  EXPECT_EQ(First, Second);
+
+  std::sort(std::begin(First), std::end(First));
+  EXPECT_EQ(std::unique(std::begin(First), std::end(First)), std::end(First));
+}
+
+TEST(Unit_Node, reseedingSkipsLiveUuids) {
+  gtirb::Context InnerCtx;
+  InnerCtx.useRandomUUIDs(42);
+  std::vector<const gtirb::Node*> Nodes;
+  for (size_t I = 0; I < 16; ++I)
+    Nodes.push_back(gtirb::Node::Create(InnerCtx));
+
+  // The generator repeats itself, but the live nodes keep their UUIDs.
+  InnerCtx.useRandomUUIDs(42);
+  for (size_t I = 0; I < 16; ++I)
+    Nodes.push_back(gtirb::Node::Create(InnerCtx));
+  std::vector<gtirb::UUID> Uuids;
+  for (const auto* N : Nodes) {
+    EXPECT_EQ(gtirb::Node::getByUUID(InnerCtx, N->getUUID()), N);
+    Uuids.push_back(N->getUUID());
+  }
+  std::sort(std::begin(Uuids), std::end(Uuids));
+  EXPECT_EQ(std::unique(std::begin(Uuids), std::end(Uuids)), std::end(Uuids));
+}
+
+TEST(Unit_Node, sequentialUuids) {
+  gtirb::Context InnerCtx;
+  InnerCtx.useSequentialUUIDs(7);
+  const auto* A = gtirb::Node::Create(InnerCtx);
+  const auto* B = gtirb::Node::Create(InnerCtx);
+
+  gtirb::UUID Expected{};
+  Expected.data[7] = 7;
+  Expected.data[15] = 1;
+  EXPECT_EQ(A->getUUID(), Expected);
+  Expected.data[15] = 2;
+  EXPECT_EQ(B->getUUID(), Expected);
+  EXPECT_EQ(gtirb::Node::getByUUID(InnerCtx, B->getUUID()), B);
+
+  // Choosing sequential UUIDs again continues the count.
+  InnerCtx.useSequentialUUIDs(7);
+  const auto* C = gtirb::Node::Create(InnerCtx);
+  Expected.data[15] = 3;
+  EXPECT_EQ(C->getUUID(), Expected);
+  EXPECT_EQ(gtirb::Node::getByUUID(InnerCtx, A->getUUID()), A);
+
+  // Switching back gives random UUIDs again.
+  InnerCtx.useRandomUUIDs();
+  EXPECT_EQ(gtirb::Node::Create(InnerCtx)->getUUID().version(),
+            gtirb::UUID::version_random_number_based);
+}
+
+TEST(Unit_Node, lazyUuids) {
+  gtirb::Context InnerCtx;
+  InnerCtx.setLazyUUIDs(true);
+  const auto* N = gtirb::Node::Create(InnerCtx);
+
+  const gtirb::UUID ID = N->getUUID();
+  EXPECT_FALSE(ID.is_nil());
+  EXPECT_EQ(N->getUUID(), ID);
+  EXPECT_EQ(gtirb::Node::getByUUID(InnerCtx, ID), N);
+
+  InnerCtx.setLazyUUIDs(false);
+  const auto* Eager = gtirb::Node::Create(InnerCtx);
+  EXPECT_NE(Eager->getUUID(), ID);
+}
+
+TEST(Unit_Node, concurrentLazyUuids) {
+  const size_t NumThreads = 8, NumNodes = 1000;
+  gtirb::Context InnerCtx;
+  InnerCtx.setLazyUUIDs(true);
+  std::vector<const gtirb::Node*> Nodes;
+  for (size_t I = 0; I < NumNodes; ++I)
+    Nodes.push_back(gtirb::Node::Create(InnerCtx));
+
+  // Every thread asks for each node's first UUID at about the same time.
+  std::vector<std::vector<gtirb::UUID>> Seen(NumThreads);
+  std::vector<std::thread> Threads;
+  for (size_t T = 0; T < NumThreads; ++T) {
+    Threads.emplace_back([&Nodes, &Ids = Seen[T]]() {
+      for (const auto* N : Nodes)
+        Ids.push_back(N->getUUID());
+    });
+  }
+  for (auto& T : Threads)
+    T.join();
+
+  for (size_t I = 0; I < NumNodes; ++I) {
+    for (size_t T = 1; T < NumThreads; ++T)
+      EXPECT_EQ(Seen[T][I], Seen[0][I]);
+    EXPECT_EQ(gtirb::Node::getByUUID(InnerCtx, Seen[0][I]), Nodes[I]);
+  }
+  EXPECT_EQ(InnerCtx.getMemoryStats().RegisteredNodes, NumNodes);
+}
+
+TEST(Unit_Node, concurrentCreation) {
+  const size_t NumThreads = 8, NumNodes = 2000;
+  gtirb::Context InnerCtx;
+  std::vector<std::vector<gtirb::Node*>> Created(NumThreads);
+
+  std::vector<std::thread> Threads;
+  for (size_t T = 0; T < NumThreads; ++T) {
+    Threads.emplace_back([&InnerCtx, &Nodes = Created[T]]() {
+      for (size_t I = 0; I < NumNodes; ++I) {
+        Nodes.push_back(gtirb::Node::Create(InnerCtx));
+        Nodes.push_back(gtirb::Symbol::Create(InnerCtx));
+      }
+    });
+  }
+  for (auto& T : Threads)
+    T.join();
+
+  std::vector<gtirb::UUID> Uuids;
+  for (const auto& Nodes : Created) {
+    for (gtirb::Node* N : Nodes) {
+      EXPECT_EQ(gtirb::Node::getByUUID(InnerCtx, N->getUUID()), N);
+      Uuids.push_back(N->getUUID());
+    }
+  }
+  std::sort(std::begin(Uuids), std::end(Uuids));
+  EXPECT_EQ(std::unique(std::begin(Uuids), std::end(Uuids)), std::end(Uuids));
+  EXPECT_EQ(Uuids.size(), NumThreads * NumNodes * 2);
+}
+
+TEST(Unit_Node, memoryStats) {
+  gtirb::Context InnerCtx;
+  gtirb::ContextMemoryStats Empty = InnerCtx.getMemoryStats();
+  EXPECT_EQ(Empty.total().LiveCount, 0);
+  EXPECT_EQ(Empty.total().SlabBytes, 0);
+  EXPECT_EQ(Empty.RegisteredNodes, 0);
+
+  const size_t NumBlocks = 1000, NumSymbols = 3;
+  for (size_t I = 0; I < NumBlocks; ++I)
+    gtirb::Block::Create(InnerCtx, gtirb::Addr(I), 1);
+  for (size_t I = 0; I < NumSymbols; ++I)
+    gtirb::Symbol::Create(InnerCtx);
+
+  gtirb::ContextMemoryStats Stats = InnerCtx.getMemoryStats();
+  EXPECT_EQ(Stats.Blocks.LiveCount, NumBlocks);
+  EXPECT_EQ(Stats.Blocks.UsedBytes, NumBlocks * sizeof(gtirb::Block));
+  EXPECT_EQ(Stats.Symbols.LiveCount, NumSymbols);
+  EXPECT_EQ(Stats.Sections.LiveCount, 0);
+  EXPECT_EQ(Stats.total().LiveCount, NumBlocks + NumSymbols);
+
+  const gtirb::NodeMemoryStats& B = Stats.Blocks;
+  EXPECT_EQ(B.SlabBytes, B.UsedBytes + B.FreeBytes + B.WastedBytes);
+  EXPECT_LT(B.WastedBytes, B.SlabBytes / 4);
+
+  EXPECT_EQ(Stats.RegisteredNodes, NumBlocks + NumSymbols);
+  EXPECT_GE(Stats.RegistryBytes,
+            Stats.RegisteredNodes * (sizeof(gtirb::UUID) + sizeof(void*)));
+}
+
+TEST(Unit_Node, contextReset) {
+  gtirb::Context InnerCtx;
+  std::vector<gtirb::UUID> Uuids;
+  for (size_t I = 0; I < 1000; ++I)
+    Uuids.push_back(
+        gtirb::Block::Create(InnerCtx, gtirb::Addr(I), 1)->getUUID());
+  size_t SlabBytes = InnerCtx.getMemoryStats().Blocks.SlabBytes;
+
+  InnerCtx.reset();
+  gtirb::ContextMemoryStats Stats = InnerCtx.getMemoryStats();
+  EXPECT_EQ(Stats.total().LiveCount, 0);
+  EXPECT_EQ(Stats.RegisteredNodes, 0);
+  EXPECT_EQ(Stats.Blocks.SlabBytes, SlabBytes);
+  EXPECT_EQ(gtirb::Node::getByUUID(InnerCtx, Uuids.front()), nullptr);
+
+  // New nodes reuse the kept slabs.
+  auto* B = gtirb::Block::Create(InnerCtx, gtirb::Addr(1), 1);
+  EXPECT_EQ(gtirb::Node::getByUUID(InnerCtx, B->getUUID()), B);
+  EXPECT_EQ(InnerCtx.getMemoryStats().Blocks.SlabBytes, SlabBytes);
+
+  InnerCtx.reset(0);
+  EXPECT_EQ(InnerCtx.getMemoryStats().total().SlabBytes, 0);
+}
+
+TEST(Unit_Node, hugePages) {
+  gtirb::Context InnerCtx;
+  EXPECT_TRUE(InnerCtx.setHugePages(true));
+  std::vector<gtirb::Symbol*> Symbols;
+  for (size_t I = 0; I < 100000; ++I) {
+    gtirb::Block::Create(InnerCtx, gtirb::Addr(I), 1);
+    Symbols.push_back(gtirb::Symbol::Create(InnerCtx, gtirb::Addr(I), "s"));
+  }
+  EXPECT_GE(InnerCtx.getMemoryStats().Blocks.SlabBytes, HugePageSize);
+  EXPECT_EQ(gtirb::Node::getByUUID(InnerCtx, Symbols.back()->getUUID()),
+            Symbols.back());
+
+  // Slabs may only change size once they have all been released.
+  EXPECT_FALSE(InnerCtx.setHugePages(false));
+  InnerCtx.reset();
+  EXPECT_FALSE(InnerCtx.setHugePages(false));
+  InnerCtx.reset(0);
+  EXPECT_TRUE(InnerCtx.setHugePages(false));
+  EXPECT_EQ(InnerCtx.getMemoryStats().RegisteredNodes, 0);
+}
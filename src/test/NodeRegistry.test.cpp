@@ -0,0 +1,94 @@
+//===- NodeRegistry.test.cpp ------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2018 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include <gtirb/Context.hpp>
+#include <gtirb/Node.hpp>
+#include <gtirb/NodeRegistry.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace gtirb;
+
+static Context Ctx;
+
+// Sequential UUIDs differ only in their last bytes, which makes collisions
+// in the table likely if the hash does not mix its input well.
+static UUID sequentialUUID(uint32_t N) {
+  UUID ID{};
+  for (int I = 0; I < 4; ++I)
+    ID.data[15 - I] = static_cast<uint8_t>(N >> (8 * I));
+  return ID;
+}
+
+TEST(Unit_NodeRegistry, emptyRegistry) {
+  NodeRegistry R;
+  EXPECT_EQ(R.size(), 0);
+  EXPECT_EQ(R.find(sequentialUUID(1)), nullptr);
+  EXPECT_FALSE(R.erase(sequentialUUID(1)));
+}
+
+TEST(Unit_NodeRegistry, insertReplacesExisting) {
+  NodeRegistry R;
+  Node* A = Node::Create(Ctx);
+  Node* B = Node::Create(Ctx);
+  R.insert(sequentialUUID(1), A);
+  R.insert(sequentialUUID(1), B);
+  EXPECT_EQ(R.size(), 1);
+  EXPECT_EQ(R.find(sequentialUUID(1)), B);
+}
+
+TEST(Unit_NodeRegistry, insertNewKeepsExisting) {
+  NodeRegistry R;
+  Node* A = Node::Create(Ctx);
+  Node* B = Node::Create(Ctx);
+  EXPECT_TRUE(R.insertNew(sequentialUUID(1), A));
+  EXPECT_FALSE(R.insertNew(sequentialUUID(1), B));
+  EXPECT_EQ(R.size(), 1);
+  EXPECT_EQ(R.find(sequentialUUID(1)), A);
+}
+
+TEST(Unit_NodeRegistry, insertFindErase) {
+  const uint32_t NumNodes = 5000;
+  NodeRegistry R;
+  std::vector<Node*> Nodes;
+  for (uint32_t I = 0; I < NumNodes; ++I) {
+    Nodes.push_back(Node::Create(Ctx));
+    R.insert(sequentialUUID(I), Nodes.back());
+  }
+  EXPECT_EQ(R.size(), NumNodes);
+  EXPECT_GE(R.capacity(), NumNodes);
+
+  // Erase every third node, then check that the others can still be found
+  // past the holes left in their probe sequences.
+  for (uint32_t I = 0; I < NumNodes; I += 3)
+    EXPECT_TRUE(R.erase(sequentialUUID(I)));
+  for (uint32_t I = 0; I < NumNodes; ++I) {
+    if (I % 3 == 0)
+      EXPECT_EQ(R.find(sequentialUUID(I)), nullptr);
+    else
+      EXPECT_EQ(R.find(sequentialUUID(I)), Nodes[I]);
+  }
+  EXPECT_EQ(R.size(), NumNodes - (NumNodes + 2) / 3);
+}
+
+TEST(Unit_NodeRegistry, clearKeepsCapacity) {
+  NodeRegistry R;
+  for (uint32_t I = 0; I < 100; ++I)
+    R.insert(sequentialUUID(I), Node::Create(Ctx));
+  size_t Capacity = R.capacity();
+  R.clear();
+  EXPECT_EQ(R.size(), 0);
+  EXPECT_EQ(R.capacity(), Capacity);
+  EXPECT_EQ(R.find(sequentialUUID(5)), nullptr);
+}
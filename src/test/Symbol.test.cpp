@@ -28,6 +28,39 @@ static Context Ctx;
 
 TEST(Unit_Symbol, ctor_0) { EXPECT_NE(Symbol::Create(Ctx), nullptr); }
 
+TEST(Unit_Symbol, internedName) {
+  Context C;
+  auto* S1 = Symbol::Create(C, "interned");
+  auto* S2 = Symbol::Create(C, Addr(1), std::string("interned"));
+  EXPECT_EQ(&S1->getName(), &S2->getName());
+  EXPECT_EQ(C.findInternedString("interned"), &S1->getName());
+  EXPECT_EQ(C.findInternedString("never used"), nullptr);
+
+  Module* M = Module::Create(C);
+  M->addSymbol(S1);
+  renameSymbol(*M, *S1, "renamed");
+  EXPECT_EQ(C.findInternedString("renamed"), &S1->getName());
+  EXPECT_EQ(S2->getName(), "interned");
+  auto Found = M->findSymbols("renamed");
+  ASSERT_EQ(std::distance(Found.begin(), Found.end()), 1);
+  EXPECT_EQ(&*Found.begin(), S1);
+  EXPECT_TRUE(M->findSymbols("interned").empty());
+
+  // A name is freed once no symbol holds it.
+  auto Stats = C.getMemoryStats();
+  EXPECT_EQ(Stats.InternedStrings, 2);
+  EXPECT_GT(Stats.InternedStringBytes, 0);
+  M->addSymbol(S2);
+  renameSymbol(*M, *S2, "renamed");
+  EXPECT_EQ(C.findInternedString("interned"), nullptr);
+  EXPECT_EQ(&S2->getName(), &S1->getName());
+  M->eraseSymbol(S1);
+  EXPECT_EQ(C.findInternedString("renamed"), &S2->getName());
+  M->eraseSymbol(S2);
+  EXPECT_EQ(C.findInternedString("renamed"), nullptr);
+  EXPECT_EQ(C.getMemoryStats().InternedStrings, 0);
+}
+
 TEST(Unit_Symbol, setStorageKind) {
   const gtirb::Symbol::StorageKind Value{gtirb::Symbol::StorageKind::Static};
 